@@ -1,6 +1,27 @@
 ﻿#include "file_io.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#include <share.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace text_overseer
 {
@@ -8,24 +29,295 @@ namespace text_overseer
 	{
 		using namespace detail;
 
+		namespace
+		{
+			// thin wrappers of the file descriptor functions of each platform
+#ifdef _WIN32
+			constexpr std::size_t k_max_io_size = 0x40000000; // _read() and _write() take an unsigned int
+
+			int fd_open(const wchar_t* path, int flags) noexcept
+			{
+				int fd = -1;
+				_wsopen_s(&fd, path, flags | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+				return fd;
+			}
+
+			long long fd_size(int fd) noexcept
+			{
+				struct _stat64 st;
+				return _fstat64(fd, &st) == 0 ? st.st_size : -1LL;
+			}
+
+			long long fd_seek(int fd, long long pos) noexcept { return _lseeki64(fd, pos, SEEK_SET); }
+			long long fd_read(int fd, void* dst, std::size_t size) noexcept
+			{
+				return _read(fd, dst, static_cast<unsigned int>(size));
+			}
+			long long fd_write(int fd, const void* src, std::size_t size) noexcept
+			{
+				return _write(fd, src, static_cast<unsigned int>(size));
+			}
+			void fd_close(int fd) noexcept { _close(fd); }
+#else
+			constexpr std::size_t k_max_io_size = 0x40000000;
+
+			int fd_open(const char* path, int flags) noexcept { return ::open(path, flags | O_CLOEXEC, 0666); }
+
+			long long fd_size(int fd) noexcept
+			{
+				struct stat st;
+				return ::fstat(fd, &st) == 0 ? static_cast<long long>(st.st_size) : -1LL;
+			}
+
+			long long fd_seek(int fd, long long pos) noexcept { return ::lseek(fd, static_cast<off_t>(pos), SEEK_SET); }
+			long long fd_read(int fd, void* dst, std::size_t size) noexcept { return ::read(fd, dst, size); }
+			long long fd_write(int fd, const void* src, std::size_t size) noexcept { return ::write(fd, src, size); }
+			void fd_close(int fd) noexcept { ::close(fd); }
+#endif
+
+			int open_flags(std::ios::openmode mode) noexcept
+			{
+				const auto is_in = (mode & std::ios::in) != 0;
+				const auto is_out = (mode & std::ios::out) != 0;
+				const auto is_app = (mode & std::ios::app) != 0;
+				const auto is_trunc = (mode & std::ios::trunc) != 0;
+
+				auto flags = is_in ? ((is_out || is_app) ? O_RDWR : O_RDONLY) : O_WRONLY;
+				if (is_app)
+					flags |= O_CREAT | O_APPEND;
+				else if (is_out && (!is_in || is_trunc)) // like std::fopen() with "w" or "w+"
+					flags |= O_CREAT | O_TRUNC;
+				return flags;
+			}
+
+			namespace filesys = boost::filesystem;
+
+			// what an atomic write must keep of the file it replaces
+			struct ReplacedFile
+			{
+				bool	exists{ false };
+				bool	has_other_links{ false }; // a rename would split a hard link off
+#ifndef _WIN32
+				struct stat st {};
+#endif
+			};
+
+			ReplacedFile inspect_replaced_file(const filesys::path& file_path) noexcept
+			{
+				ReplacedFile file;
+#ifdef _WIN32
+				const auto handle = CreateFileW(
+					file_path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+					nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+				);
+				if (handle == INVALID_HANDLE_VALUE)
+					return file;
+				BY_HANDLE_FILE_INFORMATION info;
+				if (GetFileInformationByHandle(handle, &info))
+				{
+					file.exists = true;
+					file.has_other_links = info.nNumberOfLinks > 1;
+				}
+				CloseHandle(handle);
+#else
+				if (::stat(file_path.c_str(), &file.st) == 0)
+				{
+					file.exists = true;
+					file.has_other_links = file.st.st_nlink > 1;
+				}
+#endif
+				return file;
+			}
+
+			FILE* open_to_write(const filesys::path& file_path) noexcept
+			{
+#ifdef _WIN32
+				return _wfopen(file_path.c_str(), L"wb");
+#else
+				return std::fopen(file_path.c_str(), "wb");
+#endif
+			}
+
+			// writes the BOM and the data, and closes the stream
+			// @param do_sync: whether to flush the file to the disk before closing it
+			bool write_and_close(
+				FILE*					fp,
+				const unsigned char*	bom,
+				std::size_t				bom_size,
+				const unsigned char*	data,
+				std::size_t				byte_length,
+				bool					do_sync
+			) noexcept
+			{
+				// the BOM is buffered by the stream and goes out with the text in one large write
+				auto is_written = true;
+				if (bom_size != 0)
+					is_written = std::fwrite(bom, 1, bom_size, fp) == bom_size;
+				if (is_written && byte_length != 0)
+					is_written = std::fwrite(data, 1, byte_length, fp) == byte_length;
+				if (is_written)
+					is_written = std::fflush(fp) == 0;
+				if (is_written && do_sync)
+				{
+#ifdef _WIN32
+					is_written = _commit(_fileno(fp)) == 0;
+#else
+					is_written = fsync(fileno(fp)) == 0;
+#endif
+				}
+				if (std::fclose(fp) != 0)
+					is_written = false;
+				return is_written;
+			}
+
+			// a plain truncating write, for the files a rename can't replace
+			// @throws std::runtime_error if opening or writing failed
+			bool write_in_place(
+				const filesys::path&								file_path,
+				const std::pair<const unsigned char*, std::size_t>&	bom,
+				const unsigned char*								data,
+				std::size_t											byte_length,
+				bool												do_sync
+			)
+			{
+				auto fp = open_to_write(file_path);
+				if (!fp)
+					throw std::runtime_error("cannot open the file to write");
+				if (!write_and_close(fp, bom.first, bom.second, data, byte_length, do_sync))
+					throw std::runtime_error("cannot write to the file");
+				return true;
+			}
+
+#ifdef _WIN32
+			constexpr int k_replace_retry_count = 10;
+			constexpr DWORD k_ms_replace_retry_interval = 20;
+
+			bool is_sharing_error(DWORD error) noexcept
+			{
+				return error == ERROR_SHARING_VIOLATION || error == ERROR_LOCK_VIOLATION
+					|| error == ERROR_ACCESS_DENIED || error == ERROR_UNABLE_TO_REMOVE_REPLACED;
+			}
+
+			// replaces the file with the temporary file; ReplaceFileW keeps the attributes and the ACL of the file
+			// another process having the file open without FILE_SHARE_DELETE(e.g. fopen() of a running solution)
+			// makes it fail for a while, so it's retried for a short time
+			// @returns ERROR_SUCCESS, or the last error
+			DWORD replace_file(const filesys::path& temp_path, const filesys::path& file_path, bool exists, bool do_sync)
+			{
+				const DWORD move_flags = MOVEFILE_REPLACE_EXISTING | (do_sync ? MOVEFILE_WRITE_THROUGH : 0);
+				for (int i = 0; ; i++)
+				{
+					auto is_replaced = exists
+						? ReplaceFileW(
+							file_path.c_str(), temp_path.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr
+						)
+						: MoveFileExW(temp_path.c_str(), file_path.c_str(), move_flags);
+					auto error = is_replaced ? ERROR_SUCCESS : GetLastError();
+
+					// the file was removed, but the temporary file wasn't moved into its place
+					if (error == ERROR_UNABLE_TO_MOVE_REPLACEMENT || error == ERROR_UNABLE_TO_MOVE_REPLACEMENT_2)
+					{
+						is_replaced = MoveFileExW(temp_path.c_str(), file_path.c_str(), move_flags);
+						error = is_replaced ? ERROR_SUCCESS : GetLastError();
+					}
+					if (is_replaced || !is_sharing_error(error) || i == k_replace_retry_count)
+						return error;
+					Sleep(k_ms_replace_retry_interval);
+				}
+			}
+#else
+			// makes a rename durable; some file systems can't sync a directory, but the file itself is synced already
+			void sync_directory(const filesys::path& dir_path) noexcept
+			{
+				const auto fd = ::open(dir_path.empty() ? "." : dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				if (fd < 0)
+					return;
+				fsync(fd);
+				::close(fd);
+			}
+#endif
+
+			// @param bom_size: the byte size of the found BOM; 0 if there's none
+			FileIO::encoding probe_bom(const unsigned char* head, std::size_t size, std::size_t& bom_size) noexcept
+			{
+				const auto starts_with = [head, size](const auto& bom) {
+					return size >= bom.size() && std::equal(bom.begin(), bom.end(), head);
+				};
+
+				// UTF-32LE must be checked before UTF-16LE; its BOM starts with the UTF-16LE one
+				bom_size = 0;
+				if (starts_with(bom::k_u32_le))
+					return bom_size = bom::k_u32_le.size(), FileIO::encoding::utf32_le;
+				if (starts_with(bom::k_u32_be))
+					return bom_size = bom::k_u32_be.size(), FileIO::encoding::utf32_be;
+				if (starts_with(bom::k_u8))
+					return bom_size = bom::k_u8.size(), FileIO::encoding::utf8;
+				if (starts_with(bom::k_u16_le))
+					return bom_size = bom::k_u16_le.size(), FileIO::encoding::utf16_le;
+				if (starts_with(bom::k_u16_be))
+					return bom_size = bom::k_u16_be.size(), FileIO::encoding::utf16_be;
+				return FileIO::encoding::system; // can be treated as "UTF-8 without BOM"
+			}
+		}
+
+		FileIO::FileIO(FileIO&& src) noexcept
+			: fd_(src.fd_), file_size_(src.file_size_), position_(src.position_), is_good_(src.is_good_),
+			file_openmode_(src.file_openmode_), file_locale_(src.file_locale_), newline_(src.newline_),
+			detection_confidence_(src.detection_confidence_), filename_(std::move(src.filename_))
+		{
+			src.fd_ = -1;
+		}
+
+		FileIO& FileIO::operator=(FileIO&& rhs) noexcept
+		{
+			if (this != &rhs)
+			{
+				close();
+				fd_ = rhs.fd_;
+				file_size_ = rhs.file_size_;
+				position_ = rhs.position_;
+				is_good_ = rhs.is_good_;
+				file_openmode_ = rhs.file_openmode_;
+				file_locale_ = rhs.file_locale_;
+				newline_ = rhs.newline_;
+				detection_confidence_ = rhs.detection_confidence_;
+				filename_ = std::move(rhs.filename_);
+				rhs.fd_ = -1;
+			}
+			return *this;
+		}
+
 		bool FileIO::open(std::ios::openmode mode)
 		{
-			if (filename_.empty() || file_.is_open())
+			if (filename_.empty() || is_open())
 				return false;
 			if ((mode & std::ios::binary) == false)
 				throw std::runtime_error("file stream is not binary mode");
 			file_openmode_ = mode;
-			file_.open(filename_, file_openmode_);
-			return file_.good();
+
+			fd_ = fd_open(boost::filesystem::path(filename_).c_str(), open_flags(mode));
+			if (fd_ < 0)
+				return false;
+
+			file_size_ = fd_size(fd_);
+			if (file_size_ < 0)
+			{
+				close();
+				return false;
+			}
+			// an appending file starts at its end, so the BOM is written only into an empty file
+			position_ = (mode & std::ios::app) ? file_size_ : 0LL;
+			is_good_ = true;
+			return true;
 		}
 
-		long long FileIO::stream_size()
+		void FileIO::close() noexcept
 		{
-			const auto origin_pos = file_.tellg();
-			file_.seekg(0, std::ios::end);
-			const auto file_size = static_cast<long long>(file_.tellg());
-			file_.seekg(origin_pos, std::ios::beg);
-			return file_size;
+			if (fd_ < 0)
+				return;
+			fd_close(fd_);
+			fd_ = -1;
+			is_good_ = false;
 		}
 
 		void FileIO::locale(encoding locale) noexcept
@@ -38,45 +330,57 @@ namespace text_overseer
 
 		FileIO::encoding FileIO::read_bom()
 		{
-			std::array<unsigned char, 3> buf;
+			std::array<unsigned char, 4> head;
 			if (!_read_file_check())
 				return encoding::unknown;
-			const auto file_size = stream_size();
-			file_.seekg(0, std::ios::beg);
-			if (file_size > 1)
-			{
-				file_.read(&buf[0], 2);
-				if (buf[0] == bom::k_u16_le[0] && buf[1] == bom::k_u16_le[1])
-					return encoding::utf16_le;
-				if (file_size > 2)
-				{
-					file_.read(&buf[2], 1);
-					if (buf[0] == bom::k_u8[0] && buf[1] == bom::k_u8[1] && buf[2] == bom::k_u8[2])
-						return encoding::utf8;
-				}
-			}
-			file_.seekg(0, std::ios::beg);
-			return encoding::system; // can be treated as "UTF-8 without BOM"
+			const auto read_size = static_cast<std::size_t>(std::min(file_size_, 4LL));
+			if (!_seek(0LL))
+				return encoding::unknown;
+			read_bytes(&head[0], read_size);
+
+			std::size_t bom_size;
+			const auto locale = probe_bom(&head[0], read_size, bom_size);
+			_seek(static_cast<long long>(bom_size));
+			return locale;
 		}
 
-		bool FileIO::write_bom()
+		bool FileIO::read_with_bom(std::string& bytes, std::size_t& bom_size)
 		{
-			if (!_write_file_check())
+			if (!_read_file_check() || !_seek(0LL))
 				return false;
-			file_.seekg(0, std::ios::beg);
-			if (file_locale_ == encoding::utf8)
-				file_.write(&bom::k_u8[0], bom::k_u8.size());
-			else if (file_locale_ == encoding::utf16_le)
-				file_.write(&bom::k_u16_le[0], bom::k_u16_le.size());
+
+			bytes.resize(static_cast<std::size_t>(file_size_)); // keeps the capacity of a reused buffer
+			if (!bytes.empty())
+				read_bytes(&bytes[0], bytes.size());
+
+			file_locale_ = probe_bom(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), bom_size);
+			detection_confidence_ = 1.0;
 			return true;
 		}
 
+		bool FileIO::write_bom()
+		{
+			if (!_write_file_check() || !_seek(0LL))
+				return false;
+			const auto bom = _bom();
+			return bom.second == 0 || _write_bytes(bom.first, bom.second);
+		}
+
+		std::pair<const unsigned char*, std::size_t> FileIO::_bom() const noexcept
+		{
+			return dispatch_encoding(file_locale_, [](auto reader) {
+				const auto& bom = decltype(reader)::traits::bom();
+				return std::make_pair(bom.data(), bom.size());
+			});
+		}
+
 		bool FileIO::update_locale_by_read_bom()
 		{
 			const auto locale = read_bom();
 			if (locale == encoding::unknown) // failed
 				return false;
 			file_locale_ = locale;
+			detection_confidence_ = 1.0;
 			return true;
 		}
 
@@ -87,33 +391,166 @@ namespace text_overseer
 			return buf;
 		}
 
-		std::u16string FileIO::read_all_u16()
+		std::size_t FileIO::payload_size() const noexcept
 		{
-			std::u16string buf;
-			read_all(buf, 0U, true);
-			return buf;
+			return static_cast<std::size_t>(std::max(file_size_ - position_, 0LL));
+		}
+
+		void FileIO::read_bytes(void* dst, std::size_t byte_size)
+		{
+			auto pos = static_cast<unsigned char*>(dst);
+			while (byte_size != 0)
+			{
+				const auto read_size = fd_read(fd_, pos, std::min(byte_size, k_max_io_size));
+				if (read_size <= 0) // an error, or the file has been shortened
+				{
+					is_good_ = false;
+					throw std::runtime_error("cannot read the whole file");
+				}
+				pos += read_size;
+				byte_size -= static_cast<std::size_t>(read_size);
+				position_ += read_size;
+			}
+		}
+
+		FileIO::encoding FileIO::detect_locale(const char* data, std::size_t byte_size)
+		{
+			const auto detection = detect_encoding(data, byte_size);
+			detection_confidence_ = detection.confidence;
+			if (detection.encoding == detected_encoding::utf8)
+				file_locale_ = encoding::utf8_no_bom;
+			else if (detection.encoding == detected_encoding::utf16_le)
+				file_locale_ = encoding::utf16_le;
+			else if (detection.encoding == detected_encoding::utf16_be)
+				file_locale_ = encoding::utf16_be;
+			else
+				file_locale_ = encoding::system;
+			return file_locale_;
+		}
+
+		bool FileIO::_write_all_atomic(const unsigned char* data, std::size_t byte_length, bool do_sync)
+		{
+			if (filename_.empty() || is_open())
+				return false;
+
+			// a symbolic link is kept, and the file it points to is replaced
+			filesys::path file_path(filename_);
+			boost::system::error_code ec;
+			if (filesys::is_symlink(file_path, ec))
+			{
+				const auto target_path = filesys::canonical(file_path, ec);
+				if (!ec)
+					file_path = target_path;
+			}
+
+			const auto bom = _bom();
+			const auto replaced = inspect_replaced_file(file_path);
+
+			// a rename would leave the other hard links with the old text, so it's written in place
+			if (replaced.has_other_links)
+				return write_in_place(file_path, bom, data, byte_length, do_sync);
+
+			// the temporary file must be in the same directory(file system) for the rename to be atomic
+			const auto temp_path = file_path.parent_path() / filesys::unique_path(L".%%%%-%%%%-%%%%.tmp");
+			auto fp = open_to_write(temp_path);
+			if (!fp)
+				throw std::runtime_error("cannot create a temporary file");
+
+#ifndef _WIN32
+			// the temporary file takes the permissions and the owner of the file(ReplaceFileW does it on Windows)
+			if (replaced.exists)
+			{
+				fchmod(fileno(fp), replaced.st.st_mode & 07777);
+				if (fchown(fileno(fp), replaced.st.st_uid, replaced.st.st_gid) != 0)
+				{
+					// do nothing; only the superuser can give a file away
+				}
+			}
+#endif
+
+			if (!write_and_close(fp, bom.first, bom.second, data, byte_length, do_sync))
+			{
+				filesys::remove(temp_path, ec);
+				throw std::runtime_error("cannot write to a temporary file");
+			}
+
+#ifdef _WIN32
+			const auto error = replace_file(temp_path, file_path, replaced.exists, do_sync);
+			if (error != ERROR_SUCCESS)
+			{
+				filesys::remove(temp_path, ec);
+
+				// still held by another process; it's written in place, as a plain save would do
+				if (is_sharing_error(error))
+					return write_in_place(file_path, bom, data, byte_length, do_sync);
+				throw std::runtime_error(
+					"cannot replace the file with a temporary file - "
+					+ boost::system::error_code(static_cast<int>(error), boost::system::system_category()).message()
+				);
+			}
+#else
+			filesys::rename(temp_path, file_path, ec);
+			if (ec)
+			{
+				const auto ec_rename = ec;
+				filesys::remove(temp_path, ec);
+				throw std::runtime_error("cannot replace the file with a temporary file - " + ec_rename.message());
+			}
+			if (do_sync)
+				sync_directory(file_path.parent_path());
+#endif
+
+			return true;
 		}
 
 		bool FileIO::_read_file_check()
 		{
-			if (!file_)
+			if (!is_open())
 				return false;
 			if ((file_openmode_ & std::ios::in) == false)
 				throw std::runtime_error("file stream is not input mode");
-			else
-				return file_.good();
-			return false;
+			return is_good_;
 		}
 
 		bool FileIO::_write_file_check()
 		{
-			if (!file_)
+			if (!is_open())
 				return false;
 			if ((file_openmode_ & std::ios::out) == false && (file_openmode_ & std::ios::app) == false)
 				throw std::runtime_error("file stream is not output mode");
-			else
-				return file_.good();
-			return false;
+			return is_good_;
+		}
+
+		bool FileIO::_seek(long long pos) noexcept
+		{
+			if (pos == position_)
+				return true;
+			if (fd_seek(fd_, pos) != pos)
+			{
+				is_good_ = false;
+				return false;
+			}
+			position_ = pos;
+			return true;
+		}
+
+		bool FileIO::_write_bytes(const void* src, std::size_t byte_size) noexcept
+		{
+			auto pos = static_cast<const unsigned char*>(src);
+			while (byte_size != 0)
+			{
+				const auto written_size = fd_write(fd_, pos, std::min(byte_size, k_max_io_size));
+				if (written_size <= 0)
+				{
+					is_good_ = false;
+					return false;
+				}
+				pos += written_size;
+				byte_size -= static_cast<std::size_t>(written_size);
+				position_ += written_size;
+			}
+			file_size_ = std::max(file_size_, position_);
+			return true;
 		}
 	}
 }
\ No newline at end of file
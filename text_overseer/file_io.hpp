@@ -3,7 +3,7 @@
 #include "encoding.hpp"
 
 #include <array>
-#include <fstream>
+#include <ios>
 
 namespace text_overseer
 {
@@ -11,32 +11,86 @@ namespace text_overseer
 	{
 		namespace detail
 		{
-			// bytes size limit when checking if the file is UTF-8 without BOM
-			// (there may be a rare chance to check a big file with ANSI or UTF-8 without BOM)
-			constexpr std::size_t k_max_size_check_utf8 = 0x800U;
-
 			namespace bom // Byte Order Mark
 			{
 				constexpr std::array<unsigned char, 3> k_u8{ 0xEF, 0xBB, 0xBF };
 				constexpr std::array<unsigned char, 2> k_u16_le{ 0xFF, 0xFE };
-				//constexpr std::array<unsigned char, 2> k_u16_be{ 0xFE, 0xFF };
+				constexpr std::array<unsigned char, 2> k_u16_be{ 0xFE, 0xFF };
+				constexpr std::array<unsigned char, 4> k_u32_le{ 0xFF, 0xFE, 0x00, 0x00 };
+				constexpr std::array<unsigned char, 4> k_u32_be{ 0x00, 0x00, 0xFE, 0xFF };
+				constexpr std::array<unsigned char, 0> k_none{};
 			}
 
 			namespace newline
 			{
 				constexpr std::array<unsigned char, 2> k_ascii_cr_lf{ 0x0D, 0x0A };
 				constexpr std::array<unsigned char, 4> k_u16le_cr_lf{ 0x0D, 0x00, 0x0A, 0x00 };
-				//constexpr std::array<unsigned char, 1> k_ascii_lf{ 0x0A };
-				//constexpr std::array<unsigned char, 2> k_u16le_lf{ 0x0A, 0x00 };
-
-				inline const auto& ascii() { return k_ascii_cr_lf; } // returns default ascii newline
-				inline const auto& u16le() { return k_u16le_cr_lf; } // returns default u16le newline
+				constexpr std::array<unsigned char, 4> k_u16be_cr_lf{ 0x00, 0x0D, 0x00, 0x0A };
+				constexpr std::array<unsigned char, 8> k_u32le_cr_lf{ 0x0D, 0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00 };
+				constexpr std::array<unsigned char, 8> k_u32be_cr_lf{ 0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x0A };
+				constexpr std::array<unsigned char, 1> k_ascii_lf{ 0x0A };
+				constexpr std::array<unsigned char, 2> k_u16le_lf{ 0x0A, 0x00 };
+				constexpr std::array<unsigned char, 2> k_u16be_lf{ 0x00, 0x0A };
+				constexpr std::array<unsigned char, 4> k_u32le_lf{ 0x0A, 0x00, 0x00, 0x00 };
+				constexpr std::array<unsigned char, 4> k_u32be_lf{ 0x00, 0x00, 0x00, 0x0A };
 			}
 		}
 
+		// reusable buffers for read/convert/write cycles
+		// keep one per owner(e.g. a box unit) so that their capacity survives over the cycles;
+		// in the steady state, reloading a file of a similar size makes no heap allocation
+		struct TextBuffers
+		{
+			std::string		bytes;	// raw bytes read from or to be written to a file
+			std::string		u8;		// UTF-8 text
+			std::wstring	wide;	// wide text (from or to widgets)
+			std::u16string	u16;	// UTF-16 text
+			std::u32string	u32;	// UTF-32 text
+
+			// the heap bytes held, in use or not
+			std::size_t memory_size() const noexcept
+			{
+				return bytes.capacity() + u8.capacity() + wide.capacity() * sizeof(wchar_t)
+					+ u16.capacity() * sizeof(char16_t) + u32.capacity() * sizeof(char32_t);
+			}
+
+			// clears the buffers once the text was handed over, keeping their capacity for the next cycle;
+			// a buffer holding more than max_kept_bytes(e.g. after a huge file) is freed instead
+			void trim(std::size_t max_kept_bytes) noexcept
+			{
+				_trim(bytes, max_kept_bytes);
+				_trim(u8, max_kept_bytes);
+				_trim(wide, max_kept_bytes);
+				_trim(u16, max_kept_bytes);
+				_trim(u32, max_kept_bytes);
+			}
+
+			// frees the memory, for example after a huge file was handled once
+			void release() noexcept
+			{
+				std::string().swap(bytes);
+				std::string().swap(u8);
+				std::wstring().swap(wide);
+				std::u16string().swap(u16);
+				std::u32string().swap(u32);
+			}
+
+		private:
+			template <class String>
+			static void _trim(String& str, std::size_t max_kept_bytes) noexcept
+			{
+				if (str.capacity() * sizeof(typename String::value_type) > max_kept_bytes)
+					String().swap(str);
+				else
+					str.clear();
+			}
+		};
+
 		// a class that supports text file reading & writing;
 		// it also can handle the system encoding and unicode, and can take care of BOM(Byte Order Mark)
 		// its I/O functions(read/write all/some) have checking processes assuming them occasionally called
+		// it works on a raw file descriptor; the size is taken once at open() and the position is kept by itself,
+		// so reading a whole file costs an open, a stat, a read and a close
 		class FileIO
 		{
 		public:
@@ -46,9 +100,34 @@ namespace text_overseer
 				system,			// ANSI(system locale)
 				utf8,			// UTF-8 with BOM
 				utf8_no_bom,	// UTF-8 without BOM => will be treated as ANSI if there are ASCII codes only
-				utf16_le		// UTF-16LE
+				utf16_le,		// UTF-16LE
+				utf16_be,		// UTF-16BE
+				utf32_le,		// UTF-32LE
+				utf32_be		// UTF-32BE
 			};
 
+			// the byte size of a code unit in the encoding
+			static std::size_t code_unit_size(encoding locale) noexcept
+			{
+				switch (locale)
+				{
+				case encoding::utf16_le:
+				case encoding::utf16_be:
+					return 2;
+				case encoding::utf32_le:
+				case encoding::utf32_be:
+					return 4;
+				default:
+					return 1;
+				}
+			}
+
+			// whether code units of the encoding need swapping on this (little endian) platform
+			static bool is_big_endian(encoding locale) noexcept
+			{
+				return locale == encoding::utf16_be || locale == encoding::utf32_be;
+			}
+
 			FileIO() = default;
 			FileIO(const std::wstring& filename) : filename_(filename) { }
 			FileIO(std::wstring&& filename) : filename_(std::move(filename)) { }
@@ -57,88 +136,83 @@ namespace text_overseer
 			FileIO(std::wstring&& filename, encoding file_locale)
 				: filename_(std::move(filename)), file_locale_(file_locale) { }
 
+			FileIO(const FileIO& src) = delete;
+			FileIO& operator=(const FileIO& rhs) = delete;
+			FileIO(FileIO&& src) noexcept;
+			FileIO& operator=(FileIO&& rhs) noexcept;
+
+			~FileIO() { close(); }
+
 			bool open(std::ios::openmode mode); // needs std::ios::binary
-			bool is_open() noexcept { return file_.is_open(); }
-			void close() noexcept { file_.close(); }
+			bool is_open() const noexcept { return fd_ >= 0; }
+			void close() noexcept;
 			const wchar_t* filename() const noexcept { return filename_.c_str(); }
 			const std::wstring& filename_wstring() const noexcept { return filename_; }
 
 			template <class StringT>
 			void filename(StringT&& filename) noexcept { filename_ = std::forward<StringT>(filename); }
 
-			long long stream_size(); // includes _read_file_check()
+			long long stream_size() const noexcept { return file_size_; } // taken at open(), and grows by writing
 			encoding locale() const noexcept { return file_locale_; }
+			double detection_confidence() const noexcept { return detection_confidence_; } // of the last read_all()
 			void locale(encoding locale) noexcept;
+			newline_style newline() const noexcept { return newline_; }
+			void newline(newline_style style) noexcept { newline_ = style; }
 			encoding read_bom(); // includes _read_file_check()
 			bool write_bom(); // includes _write_file_check()
 			bool update_locale_by_read_bom();  // includes read_bom()
 
+			// reads the whole file including the BOM in one read, and updates the locale by the BOM
+			// @param bom_size: the byte size of the BOM at the front of the bytes
+			// @throws std::runtime_error if the file couldn't be read entirely
+			bool read_with_bom(std::string& bytes, std::size_t& bom_size); // includes _read_file_check()
+
+			// reads the whole text after the BOM into a byte buffer, with the reader of the encoding of the file
+			// a code unit buffer needs the encoding at compile time; use Reader<E>::read_payload() for it
 			template <class MutableStringBuffer>
 			std::size_t read_all(
 				MutableStringBuffer&	buf,
 				std::size_t				buf_size,
 				bool					is_resizable
-			)
-			{
-				if (!update_locale_by_read_bom()) // includes _read_file_check()
-					return 0U;
+			);
 
-				// check the byte size of the buffer type (because of resizing)
-				auto do_use_16_bit_buffer = false;
-				if (file_locale_ == encoding::utf16_le) // when reading UTF-16LE
-				{
-					if (sizeof(buf[0]) == 2)
-						do_use_16_bit_buffer = true;
-					else if (sizeof(buf[0]) != 1) // buffer type size != 1, 2
-						throw std::invalid_argument("a mutable byte or 16-bit sequence buffer is needed for UTF-16LE");
-				}
-				else if (sizeof(buf[0]) != 1) // buffer type size != 1
-				{
-					throw std::invalid_argument("a mutable byte(8-bit) sequence buffer is needed");
-				}
-
-				const auto bom_length = file_.tellg();
-				const auto byte_size = static_cast<std::size_t>(stream_size() - bom_length);
-				const auto sequence_length = do_use_16_bit_buffer ? (byte_size / 2 + byte_size % 2) : byte_size;
-
-				// resize the buffer
-				if (buf_size < byte_size)
-				{
-					if (is_resizable)
-						_resize_buf(buf, sequence_length);
-					else
-						throw std::length_error("data size is larger than the buffer size");
-				}
-
-				file_.seekg(bom_length, std::ios::beg);
-				file_.read(reinterpret_cast<unsigned char*>(&buf[0]), byte_size);
-
-				// when encoding is system, check if it's UTF-8 without BOM, within certain bytes of string
-				if (file_locale_ == encoding::system)
-				{
-					if (utf8_check_vaild(buf, k_max_size_check_utf8, true))
-						file_locale_ = encoding::utf8_no_bom;
-				}
+			std::string read_all();
 
-				return sequence_length;
+			// reads into a reused buffer; the capacity of the buffer is kept, so it doesn't reallocate
+			// unless the file has grown larger than ever
+			template <class CharT>
+			std::size_t read_all_into(std::basic_string<CharT>& buf)
+			{
+				buf.clear();
+				return read_all(buf, 0U, true);
 			}
 
-			std::string read_all();
-			std::u16string read_all_u16();
-
 			template <class StringBuffer>
 			bool write_all(const StringBuffer& buf, std::size_t byte_length)
 			{
 				if (!write_bom()) // includes _write_file_check()
 					return false;
-				file_.write(reinterpret_cast<const unsigned char*>(&buf[0]), byte_length);
-				return true;
+				return _write_bytes(&buf[0], byte_length);
+			}
+
+			// writes the BOM and the whole buffer into a temporary file in the same directory,
+			// and then renames it into place; the file is never seen truncated or partially written
+			// the permissions(the ACL on Windows) and a symbolic link are kept; a file with other hard links,
+			// or one another process holds without sharing the deletion on Windows, is written in place instead
+			// it must be called while the file is closed
+			// @param do_sync: whether to flush the temporary file(and the directory) to the disk before renaming it
+			// @throws std::runtime_error if writing or renaming failed (the original file is left untouched,
+			//         unless it was written in place)
+			template <class ConstStringBuffer>
+			bool write_all_atomic(const ConstStringBuffer& buf, std::size_t byte_length, bool do_sync)
+			{
+				return _write_all_atomic(reinterpret_cast<const unsigned char*>(&buf[0]), byte_length, do_sync);
 			}
 
 			template <class StringBuffer>
 			bool write_some(const StringBuffer& buf, std::size_t byte_length)
 			{
-				if (file_.tellg() == 0LL)
+				if (position_ == 0LL)
 				{
 					// write BOM if the file is empty
 					if (!write_bom()) // includes _write_file_check()
@@ -149,8 +223,7 @@ namespace text_overseer
 					if (!_write_file_check())
 						return false;
 				}
-				file_.write(reinterpret_cast<const unsigned char*>(&buf[0]), byte_length);
-				return true;
+				return _write_bytes(&buf[0], byte_length);
 			}
 
 			template <class ConstStringBuffer1, class ConstStringBuffer2>
@@ -164,34 +237,40 @@ namespace text_overseer
 				if (!write_some(buf, byte_length))
 					return false;
 				// write a newline
-				file_.write(reinterpret_cast<const unsigned char*>(&newline[0]), newline.size());
-				return true;
+				return _write_bytes(&newline[0], newline.size());
 			}
 
+			// writes a line with the newline of the locale and the newline style
 			template <class ConstStringBuffer>
-			bool write_line(const ConstStringBuffer& buf, std::size_t byte_length)
-			{
-				if (file_locale_ == encoding::utf16_le)
-					return write_line(buf, byte_length, detail::newline::u16le());
-				return write_line(buf, byte_length, detail::newline::ascii());
-			}
+			bool write_line(const ConstStringBuffer& buf, std::size_t byte_length);
+
+			// low-level access for the readers
+			std::size_t payload_size() const noexcept; // the byte size after the current position(after the BOM)
+			void read_bytes(void* dst, std::size_t byte_size); // @throws std::runtime_error on a short read
+
+			// detects the encoding of a text without BOM by its byte statistics; updates the locale and the confidence
+			encoding detect_locale(const char* data, std::size_t byte_size);
 
 		protected:
-			bool FileIO::_read_file_check();
-			bool FileIO::_write_file_check();
+			bool _read_file_check();
+			bool _write_file_check();
+			bool _seek(long long pos) noexcept; // skips the syscall if it's already there
+			bool _write_bytes(const void* src, std::size_t byte_size) noexcept;
+			bool _write_all_atomic(const unsigned char* data, std::size_t byte_length, bool do_sync);
 
-			// @throws std::length_error if the file size is too big
-			template <class ResizableStringBuffer>
-			void _resize_buf(ResizableStringBuffer& buf, std::size_t size)
-			{
-				buf.resize(size);
-			}
+			// the BOM bytes of the current locale; an empty range if it has no BOM
+			std::pair<const unsigned char*, std::size_t> _bom() const noexcept;
 
-			std::basic_fstream<unsigned char>	file_;
+			int									fd_{ -1 };
+			long long							file_size_{ 0 };
+			long long							position_{ 0 };
+			bool								is_good_{ false }; // no I/O error since open()
 
 		private:
 			std::ios::openmode					file_openmode_;
 			encoding							file_locale_{ encoding::system };
+			newline_style						newline_{ newline_style::cr_lf }; // used when writing
+			double								detection_confidence_{ 1.0 };
 			std::wstring						filename_;
 		};
 
@@ -211,7 +290,7 @@ namespace text_overseer
 			// (but it's safe to use FileIO::close(); it is just a better design)
 			void close_safe() noexcept
 			{
-				// no need for check because std::basic_fstream<>::close() does check if closed
+				// no need for check because FileIO::close() does check if closed
 				file_io_->close();
 			}
 
@@ -219,5 +298,232 @@ namespace text_overseer
 			FileIO* file_io_{ nullptr };
 			bool is_closed_{ false };
 		};
+
+		// compile-time properties of each encoding; Reader<E> is specialized by them
+		// unit_type: the code unit, source_type: the source for transcode(),
+		// to_native(): makes the code units native(little endian) in place
+		template <FileIO::encoding E>
+		struct EncodingTraits;
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::system>
+		{
+			using unit_type = char;
+			using source_type = SystemSource;
+			static constexpr bool k_does_detect = true; // there's no BOM, so the encoding is detected
+			static const auto& bom() noexcept { return detail::bom::k_none; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_ascii_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_ascii_lf; }
+			static void to_native(void*, std::size_t) noexcept { }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf8>
+		{
+			using unit_type = char;
+			using source_type = Utf8ReplacingSource;
+			static constexpr bool k_does_detect = false;
+			static const auto& bom() noexcept { return detail::bom::k_u8; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_ascii_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_ascii_lf; }
+			static void to_native(void*, std::size_t) noexcept { }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf8_no_bom> : EncodingTraits<FileIO::encoding::utf8>
+		{
+			static const auto& bom() noexcept { return detail::bom::k_none; }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf16_le>
+		{
+			using unit_type = char16_t;
+			using source_type = Utf16Source<char16_t>;
+			static constexpr bool k_does_detect = false;
+			static const auto& bom() noexcept { return detail::bom::k_u16_le; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_u16le_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_u16le_lf; }
+			static void to_native(void*, std::size_t) noexcept { }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf16_be> : EncodingTraits<FileIO::encoding::utf16_le>
+		{
+			static const auto& bom() noexcept { return detail::bom::k_u16_be; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_u16be_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_u16be_lf; }
+			static void to_native(void* data, std::size_t unit_count) noexcept { swap_byte_order_16(data, unit_count); }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf32_le>
+		{
+			using unit_type = char32_t;
+			using source_type = Utf32Source;
+			static constexpr bool k_does_detect = false;
+			static const auto& bom() noexcept { return detail::bom::k_u32_le; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_u32le_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_u32le_lf; }
+			static void to_native(void*, std::size_t) noexcept { }
+		};
+
+		template <>
+		struct EncodingTraits<FileIO::encoding::utf32_be> : EncodingTraits<FileIO::encoding::utf32_le>
+		{
+			static const auto& bom() noexcept { return detail::bom::k_u32_be; }
+			static const auto& newline_cr_lf() noexcept { return detail::newline::k_u32be_cr_lf; }
+			static const auto& newline_lf() noexcept { return detail::newline::k_u32be_lf; }
+			static void to_native(void* data, std::size_t unit_count) noexcept { swap_byte_order_32(data, unit_count); }
+		};
+
+		template <FileIO::encoding E>
+		class Reader;
+
+		// calls func with the Reader of the runtime encoding; call it once per file, not per character
+		// func takes a Reader<E> object(it's empty) and uses its static functions
+		// an unknown encoding is treated as the system one
+		template <class Func>
+		decltype(auto) dispatch_encoding(FileIO::encoding locale, Func&& func)
+		{
+			using e = FileIO::encoding;
+			switch (locale)
+			{
+			case e::utf8:
+				return func(Reader<e::utf8>());
+			case e::utf8_no_bom:
+				return func(Reader<e::utf8_no_bom>());
+			case e::utf16_le:
+				return func(Reader<e::utf16_le>());
+			case e::utf16_be:
+				return func(Reader<e::utf16_be>());
+			case e::utf32_le:
+				return func(Reader<e::utf32_le>());
+			case e::utf32_be:
+				return func(Reader<e::utf32_be>());
+			default:
+				return func(Reader<e::system>());
+			}
+		}
+
+		// a text reader specialized for an encoding at compile time
+		template <FileIO::encoding E>
+		class Reader
+		{
+		public:
+			using traits = EncodingTraits<E>;
+			using unit_type = typename traits::unit_type;
+
+			// reads the whole text after the BOM; the file must be positioned right after the BOM
+			// @returns the sequence length of the text in the buffer
+			// @throws std::length_error if the text is larger than the buffer which is not resizable
+			template <class MutableStringBuffer>
+			static std::size_t read_payload(
+				FileIO&					file,
+				MutableStringBuffer&	buf,
+				std::size_t				buf_size,
+				bool					is_resizable
+			)
+			{
+				constexpr auto elem_size = sizeof(buf[0]);
+				static_assert(elem_size == 1 || elem_size == sizeof(unit_type),
+					"a mutable byte or code unit sized sequence buffer is needed");
+
+				const auto byte_size = file.payload_size();
+				const auto sequence_length = (byte_size + elem_size - 1) / elem_size;
+				if (buf_size < sequence_length)
+				{
+					if (!is_resizable)
+						throw std::length_error("data size is larger than the buffer size");
+					buf.resize(sequence_length);
+				}
+				if (byte_size != 0)
+					file.read_bytes(&buf[0], byte_size);
+				return sequence_length;
+			}
+
+			// decodes the text bytes(without the BOM) into the sink
+			// the code units are made native in place, so the bytes are modified
+			template <class Sink>
+			static void decode(char* first, char* last, Sink&& sink, newline_style style)
+			{
+				const auto unit_count = static_cast<std::size_t>(last - first) / sizeof(unit_type);
+				traits::to_native(first, unit_count);
+				const auto units = reinterpret_cast<const unit_type*>(first);
+				transcode(typename traits::source_type(units, units + unit_count), std::forward<Sink>(sink), style);
+			}
+
+			// decodes the text bytes(without the BOM) of the file into the sink
+			// if the encoding has no BOM, the detected encoding is decoded instead
+			// @returns the encoding of the decoded text
+			template <class Sink>
+			static FileIO::encoding decode_text(
+				FileIO&			file,
+				char*			first,
+				char*			last,
+				Sink&&			sink,
+				newline_style	style
+			)
+			{
+				const auto byte_size = static_cast<std::size_t>(last - first);
+				const auto locale = traits::k_does_detect ? file.detect_locale(first, byte_size) : E;
+				if (locale == E)
+				{
+					decode(first, last, std::forward<Sink>(sink), style);
+				}
+				else
+				{
+					dispatch_encoding(locale, [&](auto reader) {
+						decltype(reader)::decode(first, last, std::forward<Sink>(sink), style);
+					});
+				}
+				return locale;
+			}
+		};
+
+		// reads the whole file with one read, and decodes it into the sink
+		// the reader is chosen once by the BOM of the file; the bytes keep the whole file including the BOM
+		// @returns the encoding of the text, or FileIO::encoding::unknown if the file cannot be read
+		// @throws std::runtime_error if the file couldn't be read entirely
+		// an undecodable byte becomes U+FFFD in every encoding, so a text with garbage still shows
+		template <class Sink>
+		FileIO::encoding read_text(FileIO& file, std::string& bytes, Sink&& sink, newline_style style)
+		{
+			std::size_t bom_size;
+			if (!file.read_with_bom(bytes, bom_size)) // includes _read_file_check()
+				return FileIO::encoding::unknown;
+			const auto first = &bytes[0];
+			return dispatch_encoding(file.locale(), [&](auto reader) {
+				return decltype(reader)::decode_text(
+					file, first + bom_size, first + bytes.size(), std::forward<Sink>(sink), style
+				);
+			});
+		}
+
+		template <class MutableStringBuffer>
+		std::size_t FileIO::read_all(MutableStringBuffer& buf, std::size_t buf_size, bool is_resizable)
+		{
+			static_assert(sizeof(buf[0]) == 1, "a mutable byte sequence buffer is needed");
+
+			if (!update_locale_by_read_bom()) // includes _read_file_check()
+				return 0U;
+			const auto length = dispatch_encoding(file_locale_, [&](auto reader) {
+				return decltype(reader)::read_payload(*this, buf, buf_size, is_resizable);
+			});
+			if (file_locale_ == encoding::system)
+				detect_locale(reinterpret_cast<const char*>(&buf[0]), length);
+			return length;
+		}
+
+		template <class ConstStringBuffer>
+		bool FileIO::write_line(const ConstStringBuffer& buf, std::size_t byte_length)
+		{
+			return dispatch_encoding(file_locale_, [&](auto reader) {
+				using traits = typename decltype(reader)::traits;
+				if (newline_ == newline_style::lf)
+					return this->write_line(buf, byte_length, traits::newline_lf());
+				return this->write_line(buf, byte_length, traits::newline_cr_lf());
+			});
+		}
 	}
 }
\ No newline at end of file
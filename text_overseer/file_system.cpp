@@ -1,58 +1,521 @@
 ﻿#include "file_system.hpp"
 
+#include <cerrno>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
 namespace text_overseer
 {
 	namespace file_system
 	{
-		TimePointOfSys file_last_write_time(
-			const std::wstring&			file_path,
-			boost::system::error_code&	ec
+		namespace
+		{
+#ifdef _WIN32
+			constexpr std::int64_t k_filetime_of_unix_epoch = 116444736000000000LL; // in 100 ns since 1601
+
+			std::int64_t filetime_to_ns(const FILETIME& filetime) noexcept
+			{
+				const auto ticks = (std::uint64_t{ filetime.dwHighDateTime } << 32) | filetime.dwLowDateTime;
+				return (static_cast<std::int64_t>(ticks) - k_filetime_of_unix_epoch) * 100;
+			}
+#else
+			std::int64_t timespec_to_ns(const timespec& time) noexcept
+			{
+				return static_cast<std::int64_t>(time.tv_sec) * 1000000000LL + time.tv_nsec;
+			}
+#endif
+		}
+
+		FileStatResult stat_file(const std::wstring& file_path) noexcept
+		{
+			FileStatResult result;
+
+#ifdef _WIN32
+			// a handle only for the attributes shares everything, so it doesn't get in the way of the writers
+			const auto handle = CreateFileW(
+				file_path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+			);
+			if (handle == INVALID_HANDLE_VALUE)
+			{
+				result.ec.assign(static_cast<int>(GetLastError()), boost::system::system_category());
+				return result;
+			}
+			BY_HANDLE_FILE_INFORMATION info;
+			if (!GetFileInformationByHandle(handle, &info))
+			{
+				result.ec.assign(static_cast<int>(GetLastError()), boost::system::system_category());
+				CloseHandle(handle);
+				return result;
+			}
+			CloseHandle(handle);
+			result.stamp.mtime_ns = filetime_to_ns(info.ftLastWriteTime);
+			result.stamp.ctime_ns = filetime_to_ns(info.ftCreationTime);
+			result.stamp.size = (std::uint64_t{ info.nFileSizeHigh } << 32) | info.nFileSizeLow;
+			result.stamp.file_id = (std::uint64_t{ info.nFileIndexHigh } << 32) | info.nFileIndexLow;
+#else
+			struct stat st;
+			if (::stat(filesys::path(file_path).c_str(), &st) != 0)
+			{
+				result.ec.assign(errno, boost::system::system_category());
+				return result;
+			}
+#ifdef __APPLE__
+			result.stamp.mtime_ns = timespec_to_ns(st.st_mtimespec);
+			result.stamp.ctime_ns = timespec_to_ns(st.st_ctimespec);
+#else
+			result.stamp.mtime_ns = timespec_to_ns(st.st_mtim);
+			result.stamp.ctime_ns = timespec_to_ns(st.st_ctim);
+#endif
+			result.stamp.size = static_cast<std::uint64_t>(st.st_size);
+			result.stamp.file_id = static_cast<std::uint64_t>(st.st_ino);
+#endif
+
+			return result;
+		}
+
+		BatchIO::BatchIO(std::size_t thread_count) noexcept
+		{
+			try
+			{
+				for (std::size_t i = 0; i < thread_count; i++)
+					threads_.emplace_back([this] { this->_work(); });
+			}
+			catch (std::exception&)
+			{
+				// the batches just run with fewer workers(or on the calling thread only)
+			}
+		}
+
+		BatchIO::~BatchIO()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_stopping_ = true;
+			}
+			cv_work_.notify_all();
+			for (auto& thread : threads_)
+				thread.join();
+		}
+
+		void BatchIO::stat_all(const std::vector<const std::wstring*>& paths, std::vector<FileStatResult>& results)
+		{
+			results.resize(paths.size());
+			run_all(paths.size(), [&paths, &results](std::size_t i) {
+				results[i] = paths[i]->empty() ? FileStatResult() : stat_file(*paths[i]);
+			});
+		}
+
+		bool ChangeCoalescer::update(
+			bool					is_changed,
+			const FileStatResult&	stat,
+			clock::time_point		now,
+			clock::duration			quiet_period,
+			clock::duration			max_latency
 		) noexcept
 		{
-			std::time_t time = filesys::last_write_time(filesys::path(file_path), ec);
-			if (ec)
-				return TimePointOfSys();
-			return std::chrono::system_clock::from_time_t(time); // from_time_t(): noexcept
+			if (!is_changed)
+			{
+				is_pending_ = false; // it went back, or the owner has reloaded it by itself
+				return false;
+			}
+
+			if (!is_pending_)
+			{
+				is_pending_ = true;
+				stamp_ = stat.stamp;
+				first_change_time_ = last_change_time_ = now;
+			}
+			else if (stat.stamp != stamp_)
+			{
+				// still being written
+				stamp_ = stat.stamp;
+				last_change_time_ = now;
+			}
+
+			if (now - last_change_time_ < quiet_period && now - first_change_time_ < max_latency)
+				return false;
+			is_pending_ = false;
+			return true;
+		}
+
+		void BatchIO::run_all(std::size_t count, const std::function<void(std::size_t)>& job) noexcept
+		{
+			if (count == 0)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				job_ = &job;
+				job_count_ = count;
+				next_index_ = 0;
+				busy_count_ = threads_.size();
+				generation_++;
+			}
+			cv_work_.notify_all();
+
+			_run_jobs();
+
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_done_.wait(lock, [this] { return busy_count_ == 0; });
+			job_ = nullptr;
+		}
+
+		void BatchIO::_work() noexcept
+		{
+			std::size_t done_generation = 0;
+			std::unique_lock<std::mutex> lock(mutex_);
+			for (;;)
+			{
+				cv_work_.wait(lock, [this, &done_generation] {
+					return is_stopping_ || generation_ != done_generation;
+				});
+				if (is_stopping_)
+					return;
+				done_generation = generation_;
+
+				lock.unlock();
+				_run_jobs();
+				lock.lock();
+
+				if (--busy_count_ == 0)
+					cv_done_.notify_one();
+			}
+		}
+
+		void BatchIO::_run_jobs() noexcept
+		{
+			for (;;)
+			{
+				const auto i = next_index_.fetch_add(1);
+				if (i >= job_count_)
+					break;
+				try
+				{
+					(*job_)(i);
+				}
+				catch (std::exception&)
+				{
+					// do nothing
+				}
+			}
 		}
 
-		std::pair<std::vector<IOFilePathPair>, std::vector<FilePathErrorCode>>
+		constexpr FilenamePattern::char_type FilenamePattern::k_any_one;
+
+		FilenamePattern::FilenamePattern(const std::wstring& pattern)
+		{
+			if (pattern.empty())
+				return;
+
+			const auto native = filesys::path(pattern).native();
+			segments_.push_back(Segment{ 0, 0 });
+			for (const auto c : native)
+			{
+				if (c == '*')
+				{
+					segments_.push_back(Segment{ elements_.size(), 0 });
+				}
+				else
+				{
+					elements_.push_back(c == '?' ? k_any_one : c);
+					segments_.back().size++;
+				}
+			}
+		}
+
+		bool FilenamePattern::match(const char_type* first, const char_type* last, string_type& key) const
+		{
+			if (segments_.empty() || static_cast<std::size_t>(last - first) < elements_.size())
+				return false;
+
+			const auto& head = segments_.front();
+			key.clear();
+
+			if (segments_.size() == 1) // no '*'
+			{
+				if (static_cast<std::size_t>(last - first) != head.size || !_match_segment(head, first))
+					return false;
+				_append_any_ones(head, first, key);
+				return true;
+			}
+
+			// the anchored segments first; they reject most of the names
+			const auto& tail = segments_.back();
+			const auto tail_first = last - tail.size;
+			if (!_match_segment(tail, tail_first) || !_match_segment(head, first))
+				return false;
+
+			_append_any_ones(head, first, key);
+			auto pos = first + head.size;
+
+			// the leftmost match of a middle segment leaves the most room for the rest
+			for (std::size_t i = 1; i + 1 < segments_.size(); i++)
+			{
+				const auto& segment = segments_[i];
+				auto found = pos;
+				while (found + segment.size <= tail_first && !_match_segment(segment, found))
+					found++;
+				if (found + segment.size > tail_first)
+					return false;
+				key.append(pos, found);
+				key.push_back(0);
+				_append_any_ones(segment, found, key);
+				pos = found + segment.size;
+			}
+
+			key.append(pos, tail_first);
+			key.push_back(0);
+			_append_any_ones(tail, tail_first, key);
+			return true;
+		}
+
+		bool FilenamePattern::instantiate(const string_type& key, string_type& filename) const
+		{
+			filename.clear();
+			std::size_t key_pos = 0;
+
+			// takes the text of the next wildcard from the key
+			const auto take_wildcard = [&key, &key_pos, &filename]() -> std::size_t {
+				const auto end = key.find(char_type(0), key_pos);
+				if (end == string_type::npos)
+					return string_type::npos;
+				filename.append(key, key_pos, end - key_pos);
+				const auto size = end - key_pos;
+				key_pos = end + 1;
+				return size;
+			};
+
+			for (std::size_t i = 0; i < segments_.size(); i++)
+			{
+				if (i != 0 && take_wildcard() == string_type::npos) // the '*' before the segment
+					return false;
+
+				const auto& segment = segments_[i];
+				for (std::size_t j = 0; j < segment.size; j++)
+				{
+					const auto c = elements_[segment.first + j];
+					if (c != k_any_one)
+						filename.push_back(c);
+					else if (take_wildcard() != 1)
+						return false;
+				}
+			}
+			return !segments_.empty() && key_pos == key.size();
+		}
+
+		bool FilenamePattern::_match_segment(const Segment& segment, const char_type* pos) const noexcept
+		{
+			const auto elements = elements_.data() + segment.first;
+			for (std::size_t i = 0; i < segment.size; i++)
+			{
+				if (elements[i] != k_any_one && elements[i] != pos[i])
+					return false;
+			}
+			return true;
+		}
+
+		void FilenamePattern::_append_any_ones(const Segment& segment, const char_type* pos, string_type& key) const
+		{
+			const auto elements = elements_.data() + segment.first;
+			for (std::size_t i = 0; i < segment.size; i++)
+			{
+				if (elements[i] == k_any_one)
+				{
+					key.push_back(pos[i]);
+					key.push_back(0);
+				}
+			}
+		}
+
+		IOFilePairer::IOFilePairer(
+			const std::vector<IOFilePatterns>&	patterns,
+			bool								do_always_create_both_path,
+			const std::atomic<bool>*			cancel_flag
+		) : do_always_create_both_path_(do_always_create_both_path), cancel_flag_(cancel_flag)
+		{
+			for (const auto& set : patterns)
+			{
+				sets_.push_back(PatternSet{
+					FilenamePattern(set.input), FilenamePattern(set.output), FilenamePattern(set.answer)
+				});
+			}
+		}
+
+		void IOFilePairer::add(const filesys::path& file_path)
+		{
+			// the filename is taken from the native path string, without making a path of it
+			const auto& native = file_path.native();
+			const auto last = native.data() + native.size();
+			auto first = last;
+			while (first != native.data() && first[-1] != '/' && first[-1] != filesys::path::preferred_separator)
+				first--;
+
+			for (std::size_t i = 0; i < sets_.size(); i++)
+			{
+				const auto& set = sets_[i];
+				std::wstring IOFilePaths::* file = nullptr;
+				if (set.input.match(first, last, key_))
+					file = &IOFilePaths::input;
+				else if (set.output.match(first, last, key_))
+					file = &IOFilePaths::output;
+				else if (set.answer.match(first, last, key_))
+					file = &IOFilePaths::answer;
+				else
+					continue;
+				groups_[std::make_pair(i, key_)].*file = file_path.wstring(); // only a matched name is converted
+				return; // the former sets take precedence
+			}
+		}
+
+		void IOFilePairer::flush(std::vector<IOFilePaths>& found)
+		{
+			for (auto& group : groups_)
+			{
+				auto& file_paths = group.second;
+				if (file_paths.input.empty() && file_paths.output.empty())
+					continue; // an answer file alone isn't a test case
+				file_paths.key = filesys::path(group.first.second).wstring();
+
+				if (do_always_create_both_path_)
+				{
+					const auto& set = sets_[group.first.first];
+					const auto& key = group.first.second;
+					if (file_paths.output.empty())
+						_make_sibling_path(file_paths.input, set.output, key, file_paths.output);
+					else if (file_paths.input.empty())
+						_make_sibling_path(file_paths.output, set.input, key, file_paths.input);
+				}
+
+				found.push_back(std::move(file_paths));
+			}
+			groups_.clear();
+		}
+
+		void IOFilePairer::_make_sibling_path(
+			const std::wstring&						sibling,
+			const FilenamePattern&					pattern,
+			const FilenamePattern::string_type&		key,
+			std::wstring&							path_str
+		)
+		{
+			if (!pattern.instantiate(key, filename_))
+				return;
+			path_str = sibling.substr(0, sibling.find_last_of(L"/\\") + 1) + filesys::path(filename_).wstring();
+		}
+
+		std::vector<IOFilePatterns> parse_io_file_patterns(const std::wstring& text)
+		{
+			std::vector<IOFilePatterns> patterns;
+			std::wistringstream iss(text);
+			std::wstring line;
+
+			while (std::getline(iss, line))
+			{
+				std::wistringstream fields(line);
+				IOFilePatterns set;
+				if (!(fields >> set.input) || set.input[0] == L'#' || !(fields >> set.output))
+					continue;
+				fields >> set.answer; // optional
+				patterns.push_back(std::move(set));
+			}
+			return patterns;
+		}
+
+		std::pair<std::vector<IOFilePaths>, std::vector<FilePathErrorCode>>
 			search_input_output_files(
-				const std::wstring& input_filename,
-				const std::wstring& output_filename,
-				bool				do_always_create_both_path,
-				const std::wstring& dir_path
+				const std::vector<IOFilePatterns>&	patterns,
+				bool								do_always_create_both_path,
+				const std::wstring&					dir_path
 			) noexcept
 		{
-			std::vector<IOFilePathPair> io_files;
+			std::vector<IOFilePaths> io_files;
 			std::vector<FilePathErrorCode> ecs_with_path;
 
-			search_file_pairs(
-				std::make_pair(input_filename, output_filename),
-				dir_path,
-				io_files,
-				ecs_with_path,
-				true
-			);
+			IOFilePairer pairer(patterns, do_always_create_both_path);
+			search_file_pairs(pairer, filesys::path(dir_path), io_files, ecs_with_path, true);
+
+			return std::make_pair(io_files, ecs_with_path);
+		}
 
-			// even if either of two files doesn't exist, it can return both of those path strings
-			if (do_always_create_both_path)
+		AsyncFileSearch::~AsyncFileSearch()
+		{
+			cancel();
+		}
+
+		void AsyncFileSearch::start(
+			std::vector<IOFilePatterns>	patterns,
+			bool						do_always_create_both_path,
+			std::wstring				dir_path
+		)
+		{
+			cancel(); // the former worker is joined, so nothing is pushed any more
+
+			IOFilePaths discarded;
+			while (found_.try_pop(discarded))
+				;
+			ecs_with_path_.clear();
+			is_done_ = false;
+			is_cancelled_ = false;
+
+			thread_ = std::thread([this, patterns = std::move(patterns), do_always_create_both_path,
+				dir_path = std::move(dir_path)]
 			{
-				for (auto& file_pair : io_files)
+				std::vector<FilePathErrorCode> ecs_with_path;
+				try
 				{
-					if (file_pair.second.empty())
-					{
-						file_pair.second = file_pair.first.substr(0, file_pair.first.find_last_of(L"/\\") + 1)
-							+ output_filename;
-					}
-					else if (file_pair.first.empty())
-					{
-						file_pair.first = file_pair.second.substr(0, file_pair.second.find_last_of(L"/\\") + 1)
-							+ input_filename;
-					}
+					IOFilePairer pairer(patterns, do_always_create_both_path, &this->is_cancelled_);
+					search_file_pairs(pairer, filesys::path(dir_path), *this, ecs_with_path, true);
 				}
+				catch (std::exception&)
+				{
+					// the ones found so far are given
+				}
+
+				this->ecs_with_path_ = std::move(ecs_with_path);
+				this->is_done_.store(true, std::memory_order_release); // publishes the ecs and all the pushes
+			});
+		}
+
+		void AsyncFileSearch::cancel() noexcept
+		{
+			is_cancelled_ = true;
+			if (thread_.joinable())
+				thread_.join();
+		}
+
+		bool AsyncFileSearch::take(std::vector<IOFilePaths>& found, std::vector<FilePathErrorCode>& ecs_with_path)
+		{
+			// loaded before popping, so if it's done, everything found is popped below
+			const auto is_done = is_done_.load(std::memory_order_acquire);
+
+			found.clear();
+			IOFilePaths file_paths;
+			while (found_.try_pop(file_paths))
+				found.push_back(std::move(file_paths));
+
+			if (is_done)
+			{
+				ecs_with_path.clear();
+				ecs_with_path.swap(ecs_with_path_);
 			}
+			return is_done;
+		}
 
-			return std::make_pair(io_files, ecs_with_path);
+		void AsyncFileSearch::insert(iterator, IOFilePaths&& file_paths)
+		{
+			found_.push(std::move(file_paths));
 		}
 	}
 }
\ No newline at end of file
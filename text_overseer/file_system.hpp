@@ -1,9 +1,16 @@
 ﻿#pragma once
 
 #include <boost/filesystem.hpp>
-#include <boost/lexical_cast.hpp>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -13,7 +20,115 @@ namespace text_overseer
 	{
 		namespace filesys = boost::filesystem;
 
-		using IOFilePathPair = std::pair<std::wstring, std::wstring>;
+		constexpr std::size_t k_batch_io_threads = 8; // I/O bound, so it doesn't follow the number of cores
+
+		// the files of a test case; the answer is optional, so its path stays empty if there's no answer file
+		struct IOFilePaths
+		{
+			std::wstring input;
+			std::wstring output;
+			std::wstring answer;
+			std::wstring key; // what the wildcards matched(e.g. "1" of 1.in); empty if the patterns have none
+		};
+
+		// the filename patterns of a test case; '*' matches any characters, and '?' matches a character
+		// the files of a folder whose wildcards match the same text are paired(e.g. 1.in, 1.out and 1.ans)
+		// the answer pattern can be empty
+		// if a filename matches more than one set, only the first set in the order given takes it
+		struct IOFilePatterns
+		{
+			std::wstring input;
+			std::wstring output;
+			std::wstring answer;
+		};
+
+		const std::vector<IOFilePatterns> k_default_io_file_patterns{
+			{ L"input.txt", L"output.txt", L"answer.txt" },
+			{ L"*.in", L"*.out", L"*.ans" }
+		};
+
+		// a filename pattern compiled once; it's split by '*' into the segments,
+		// and the first and the last segment are anchored, so a name is matched without backtracking
+		// the names are matched in the native character type of the paths, so they're never converted
+		class FilenamePattern
+		{
+		public:
+			using char_type = filesys::path::value_type;
+			using string_type = filesys::path::string_type;
+
+			FilenamePattern() = default;
+			explicit FilenamePattern(const std::wstring& pattern);
+
+			bool empty() const noexcept { return segments_.empty(); }
+
+			// @param key: the text matched by each wildcard, each of them followed by '\0';
+			//        the files of a test case have the same key
+			bool match(const char_type* first, const char_type* last, string_type& key) const;
+
+			// makes the filename whose wildcards match the key; false if the key doesn't fit the pattern
+			bool instantiate(const string_type& key, string_type& filename) const;
+
+		private:
+			static constexpr char_type k_any_one = 0; // '\0' can't be in a filename, so it marks '?' in elements_
+
+			struct Segment
+			{
+				std::size_t first; // in elements_
+				std::size_t size;
+			};
+
+			bool _match_segment(const Segment& segment, const char_type* pos) const noexcept;
+			void _append_any_ones(const Segment& segment, const char_type* pos, string_type& key) const;
+
+			string_type				elements_; // the pattern without '*'s
+			std::vector<Segment>	segments_; // split by '*'; there's a '*' between every two of them
+		};
+
+		// groups the files of a folder into test cases by the filename patterns
+		class IOFilePairer
+		{
+		public:
+			// @param do_always_create_both_path: even if either of the input and the output file doesn't exist,
+			//        make both of the paths by the patterns (an answer file is optional, so its path isn't made)
+			// @param cancel_flag: the search stops when it gets true; it can be null
+			IOFilePairer(
+				const std::vector<IOFilePatterns>&	patterns,
+				bool								do_always_create_both_path,
+				const std::atomic<bool>*			cancel_flag = nullptr
+			);
+
+			bool is_cancelled() const noexcept { return cancel_flag_ != nullptr && *cancel_flag_; }
+
+			// a regular file of the folder; it goes to the first pattern set matching it, so sets never share a file
+			void add(const filesys::path& file_path);
+			void flush(std::vector<IOFilePaths>& found); // moves the test cases of the folder, sorted by the keys
+
+		private:
+			struct PatternSet
+			{
+				FilenamePattern input;
+				FilenamePattern output;
+				FilenamePattern answer;
+			};
+
+			// makes the path of a missing file in the folder of the sibling file
+			void _make_sibling_path(
+				const std::wstring&						sibling,
+				const FilenamePattern&					pattern,
+				const FilenamePattern::string_type&		key,
+				std::wstring&							path_str
+			);
+
+			std::vector<PatternSet> sets_;
+			bool do_always_create_both_path_;
+			const std::atomic<bool>* cancel_flag_;
+			std::map<std::pair<std::size_t, FilenamePattern::string_type>, IOFilePaths> groups_; // by (set, key)
+			FilenamePattern::string_type key_;
+			FilenamePattern::string_type filename_;
+		};
+
+		// parses the lines of "input output [answer]" patterns; a line starting with '#' is a comment
+		std::vector<IOFilePatterns> parse_io_file_patterns(const std::wstring& text);
 		using TimePointOfSys = std::chrono::time_point<std::chrono::system_clock/*, std::chrono::seconds*/>;
 
 		class FilePathErrorCode
@@ -33,10 +148,109 @@ namespace text_overseer
 			boost::system::error_code	ec_;
 		};
 
-		TimePointOfSys file_last_write_time(
-			const std::wstring&			file_path,
-			boost::system::error_code&	ec
-		) noexcept;
+		// a compact record of a version of a file; any difference in it means the file was changed
+		// the write time has sub-second precision(100 ns on Windows, 1 ns elsewhere),
+		// so rewrites within a second are told apart, and so are the rewrites keeping the write time
+		struct FileStamp
+		{
+			std::int64_t	mtime_ns{ 0 };	// the last write time, in nanoseconds since the epoch; 0 if unknown
+			std::int64_t	ctime_ns{ 0 };	// the status change time(POSIX) or the creation time(Windows)
+			std::uint64_t	size{ 0 };
+			std::uint64_t	file_id{ 0 };	// the inode, or the file index on Windows; a replaced file gets a new one
+
+			TimePointOfSys last_write_time() const noexcept
+			{
+				return TimePointOfSys(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+					std::chrono::nanoseconds(mtime_ns)
+				));
+			}
+
+			bool is_known() const noexcept { return mtime_ns != 0; }
+
+			bool operator==(const FileStamp& rhs) const noexcept
+			{
+				return mtime_ns == rhs.mtime_ns && ctime_ns == rhs.ctime_ns
+					&& size == rhs.size && file_id == rhs.file_id;
+			}
+
+			bool operator!=(const FileStamp& rhs) const noexcept { return !(*this == rhs); }
+		};
+
+		struct FileStatResult
+		{
+			FileStamp					stamp;
+			boost::system::error_code	ec;
+
+			TimePointOfSys last_write_time() const noexcept { return stamp.last_write_time(); }
+		};
+
+		// takes the stamp of a file(GetFileInformationByHandle on a handle for the attributes on Windows, stat() elsewhere)
+		FileStatResult stat_file(const std::wstring& file_path) noexcept;
+
+		// coalesces a burst of changes of a file into one; a file written in many small flushes is reloaded
+		// once it has settled, not on every stat in the middle of the burst
+		// a change is due when the stamp of the file has been the same for the quiet period,
+		// or when the max latency has passed since the first change of the burst
+		class ChangeCoalescer
+		{
+		public:
+			using clock = std::chrono::steady_clock;
+
+			// @param is_changed: whether the stat is newer than the file the owner has
+			// @returns true if the change is due now; the owner should reload the file then
+			bool update(
+				bool					is_changed,
+				const FileStatResult&	stat,
+				clock::time_point		now,
+				clock::duration			quiet_period,
+				clock::duration			max_latency
+			) noexcept;
+
+			bool is_pending() const noexcept { return is_pending_; }
+
+		private:
+			bool				is_pending_{ false };
+			FileStamp			stamp_;
+			clock::time_point	first_change_time_;
+			clock::time_point	last_change_time_;
+		};
+
+		// runs a batch of file system jobs on a pool of worker threads and waits until all of them are done
+		// the latency of the jobs overlaps, so a batch of stats takes about the slowest one, not the sum of all
+		// (there's no batched stat syscall on Windows; this is the portable way to get the same effect)
+		// the workers are kept over the batches; the calling thread works on the batch too
+		class BatchIO
+		{
+		public:
+			explicit BatchIO(std::size_t thread_count = k_batch_io_threads) noexcept;
+			~BatchIO();
+
+			BatchIO(const BatchIO& src) = delete;
+			BatchIO& operator=(const BatchIO& rhs) = delete;
+
+			// stats the last write time of every path; an empty path gets a zero time point without an error
+			// @param results: resized to the number of the paths
+			void stat_all(const std::vector<const std::wstring*>& paths, std::vector<FileStatResult>& results);
+
+			// calls job(i) for every i in [0, count); the jobs must not touch any widget
+			// an exception from a job is ignored, so a job shall keep its own result
+			void run_all(std::size_t count, const std::function<void(std::size_t)>& job) noexcept;
+
+		private:
+			void _work() noexcept;
+			void _run_jobs() noexcept; // takes job indices until all are taken
+
+			std::vector<std::thread>					threads_;
+			std::mutex									mutex_;
+			std::condition_variable						cv_work_;
+			std::condition_variable						cv_done_;
+			const std::function<void(std::size_t)>*		job_{ nullptr };
+			std::size_t									job_count_{ 0 };
+			std::atomic<std::size_t>					next_index_{ 0 };
+			std::size_t									busy_count_{ 0 }; // workers still on the current batch
+			std::size_t									generation_{ 0 }; // increases for each batch
+			bool										is_stopping_{ false };
+		};
 
 		// @param filename: file name to search files match it
 		// @param dir_path: directory path to start a search
@@ -75,64 +289,163 @@ namespace text_overseer
 			}
 		}
 
-		template <class MutableWstringPairContainer>
+		template <class MutableIOFilePathsContainer>
 		void search_file_pairs(
-			const IOFilePathPair&			filenames,
-			std::wstring					dir_path,
-			MutableWstringPairContainer&	initialized_buf,
+			IOFilePairer&					pairer,
+			const filesys::path&			dir_path,
+			MutableIOFilePathsContainer&	initialized_buf,
 			std::vector<FilePathErrorCode>& ecs_with_path,
 			bool							do_search_subfolders
 		) noexcept
 		{
 			boost::system::error_code ec;
 
+			if (pairer.is_cancelled())
+				return;
+
 			if (!filesys::is_directory(dir_path, ec))
 			{
-				ecs_with_path.emplace_back(dir_path, ec);
+				ecs_with_path.emplace_back(dir_path.wstring(), ec);
 				return;
 			}
 
-			IOFilePathPair result;
-			std::vector<std::wstring> subfolders;
+			std::vector<filesys::path> subfolders;
 
 			for (const filesys::directory_entry& x : filesys::directory_iterator(dir_path, ec))
 			{
+				if (pairer.is_cancelled())
+					return; // a folder can have a huge number of entries; the cases half grouped are dropped
 				ec.clear();
-				if (filesys::is_regular_file(x.path(), ec))
-				{
-					if (x.path().filename().wstring() == filenames.first)
-						result.first = x.path().wstring();
-					else if (x.path().filename().wstring() == filenames.second)
-						result.second = x.path().wstring();
-				}
-				else if (do_search_subfolders && filesys::is_directory(x.path(), ec))
-				{
-					subfolders.emplace_back(x.path().wstring());
-				}
+				// the status is cached by the directory iteration if the system tells the file type
+				const auto status = x.status(ec);
+				if (filesys::is_regular_file(status))
+					pairer.add(x.path());
+				else if (do_search_subfolders && filesys::is_directory(status))
+					subfolders.emplace_back(x.path());
 				if (ec)
 					ecs_with_path.emplace_back(x.path().wstring(), ec);
 			}
 
-			if (!result.first.empty() || !result.second.empty())
-				initialized_buf.insert(std::end(initialized_buf), result);
+			try
+			{
+				std::vector<IOFilePaths> found;
+				pairer.flush(found);
+				for (auto& file_paths : found)
+					initialized_buf.insert(std::end(initialized_buf), std::move(file_paths));
+			}
+			catch (std::exception&)
+			{
+				// do nothing
+			}
 
 			// search on the subfolders
 			for (const auto& subfolder : subfolders)
-				search_file_pairs(filenames, subfolder, initialized_buf, ecs_with_path, true);
+				search_file_pairs(pairer, subfolder, initialized_buf, ecs_with_path, true);
 		}
 
-		// @param input_filename: file name of input file
-		// @param output_filename: file name of output file
+		// @param patterns: the filename patterns of the test cases; see IOFilePatterns
 		// @param dir_path: directory path to start a search;
 		//        a default value is the current directory path, where locates this program
-		std::pair<std::vector<IOFilePathPair>, std::vector<FilePathErrorCode>>
+		std::pair<std::vector<IOFilePaths>, std::vector<FilePathErrorCode>>
 			search_input_output_files(
-				const std::wstring& input_filename,
-				const std::wstring& output_filename,
-				bool				do_always_create_both_path = true,
-				const std::wstring& dir_path = filesys::current_path().wstring()
+				const std::vector<IOFilePatterns>&	patterns,
+				bool								do_always_create_both_path = true,
+				const std::wstring&					dir_path = filesys::current_path().wstring()
 			) noexcept;
 
+		// an unbounded queue between one producer thread and one consumer thread, without a lock
+		// it carries what a long-running worker(e.g. AsyncFileSearch) hands to the GUI thread; the reloads and the
+		// saves aren't queued, since BatchIO runs the loads within a timer tick and a save shows message boxes
+		// the producer links a node at the tail and the consumer unlinks at the head, which is always a dummy node,
+		// so they never touch the same node at once
+		template <class T>
+		class SpscQueue
+		{
+		public:
+			SpscQueue() : head_(new Node()), tail_(head_) { }
+			~SpscQueue()
+			{
+				while (head_ != nullptr)
+				{
+					const auto next = head_->next.load(std::memory_order_relaxed);
+					delete head_;
+					head_ = next;
+				}
+			}
+
+			SpscQueue(const SpscQueue& src) = delete;
+			SpscQueue& operator=(const SpscQueue& rhs) = delete;
+
+			// only called by the producer thread
+			void push(T&& value)
+			{
+				const auto node = new Node();
+				node->value = std::move(value);
+				tail_->next.store(node, std::memory_order_release); // the value is seen with the node
+				tail_ = node;
+			}
+
+			// only called by the consumer thread
+			// @returns false if it's empty
+			bool try_pop(T& value)
+			{
+				const auto next = head_->next.load(std::memory_order_acquire);
+				if (next == nullptr)
+					return false;
+				value = std::move(next->value);
+				delete head_;
+				head_ = next; // the node popped is the new dummy
+				return true;
+			}
+
+		private:
+			struct Node
+			{
+				std::atomic<Node*>	next{ nullptr };
+				T					value;
+			};
+
+			alignas(64) Node* head_; // the consumer's
+			alignas(64) Node* tail_; // the producer's
+		};
+
+		// searches the test cases on a worker thread; the GUI thread takes the ones found as they come,
+		// a folder at a time, instead of waiting for the whole search
+		class AsyncFileSearch
+		{
+		public:
+			AsyncFileSearch() = default;
+			~AsyncFileSearch();
+
+			AsyncFileSearch(const AsyncFileSearch& src) = delete;
+			AsyncFileSearch& operator=(const AsyncFileSearch& rhs) = delete;
+
+			// cancels the former search if it's still running
+			void start(
+				std::vector<IOFilePatterns>	patterns,
+				bool						do_always_create_both_path = true,
+				std::wstring				dir_path = filesys::current_path().wstring()
+			);
+			void cancel() noexcept; // waits until the worker stops
+
+			// moves the test cases found since the last call
+			// @param ecs_with_path: the error codes are given when the search is done
+			// @returns true if the search is done
+			bool take(std::vector<IOFilePaths>& found, std::vector<FilePathErrorCode>& ecs_with_path);
+
+			// the container interface for search_file_pairs(), which the worker uses
+			struct iterator { };
+			iterator end() noexcept { return iterator(); }
+			void insert(iterator, IOFilePaths&& file_paths);
+
+		private:
+			std::thread						thread_;
+			SpscQueue<IOFilePaths>			found_; // the worker pushes, the GUI thread pops
+			std::vector<FilePathErrorCode>	ecs_with_path_; // set by the worker before is_done_
+			std::atomic<bool>				is_cancelled_{ false };
+			std::atomic<bool>				is_done_{ true };
+		};
+
 		namespace time_period_strings
 		{
 			template <class StringT>
@@ -165,18 +478,67 @@ namespace text_overseer
 		template <class T>
 		using TimePeriodStringsT = time_period_strings::TimePeriodStringsT<T>;
 
-		template <class StringT, class PeriodStringT, class Rep, class Period>
-		StringT time_duration_to_string(
+		// the size of a buffer large enough for any string of write_time_duration()
+		constexpr std::size_t k_time_duration_buffer_size = 160;
+
+		namespace time_duration_chars
+		{
+			template <class CharT>
+			CharT* append(CharT* it, CharT* last, const CharT* str) noexcept
+			{
+				while (*str != CharT() && it != last)
+					*it++ = *str++;
+				return it;
+			}
+
+			template <class CharT, class Traits, class Alloc>
+			CharT* append(CharT* it, CharT* last, const std::basic_string<CharT, Traits, Alloc>& str) noexcept
+			{
+				for (auto c : str)
+				{
+					if (it == last)
+						break;
+					*it++ = c;
+				}
+				return it;
+			}
+
+			// the digits are written backward into a local buffer and then copied, without any stream
+			template <class CharT>
+			CharT* append_uint(CharT* it, CharT* last, std::uint64_t num) noexcept
+			{
+				CharT digits[20];
+				auto digit_it = std::end(digits);
+				do
+				{
+					*--digit_it = static_cast<CharT>('0' + num % 10);
+					num /= 10;
+				} while (num != 0);
+
+				while (digit_it != std::end(digits) && it != last)
+					*it++ = *digit_it++;
+				return it;
+			}
+		}
+
+		// writes a string representing the duration into [first, last) and returns the end of the string
+		// it doesn't allocate, so it's cheap enough to call on every timer tick
+		template <class CharT, class PeriodStringT, class Rep, class Period>
+		CharT* write_time_duration(
+			CharT*										first,
+			CharT*										last,
 			const std::chrono::duration<Rep, Period>&	duration,
 			bool										do_cut_smaller_periods,
 			const TimePeriodStringsT<PeriodStringT>&	periods
-		)
+		) noexcept
 		{
+			namespace chars = time_duration_chars;
+
 			enum class PeriodEnum { msecs, secs, mins, hours, days } base_period;
 			const auto counted = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
 
-			if (counted == 0)
-				return periods.just_a_moment;
+			if (counted <= 0)
+				return chars::append(first, last, periods.just_a_moment);
 
 			if (std::ratio_greater_equal<Period, std::ratio<86400>>())
 				base_period = PeriodEnum::days;
@@ -189,7 +551,7 @@ namespace text_overseer
 			else
 				base_period = PeriodEnum::msecs;
 
-			auto remainder = counted;
+			auto remainder = static_cast<std::uint64_t>(counted);
 			const auto msecs = remainder % 1000;
 			remainder /= 1000;
 			const auto secs = remainder % 60;
@@ -198,52 +560,65 @@ namespace text_overseer
 			remainder /= 60;
 			const auto hours = remainder % 24;
 			remainder /= 24;
-			const auto days = std::move(remainder);
+			const auto days = remainder;
 
 			// check if the duration is smaller than a base period
-			if ((counted == 0 && base_period == PeriodEnum::msecs)
-				|| (counted < 1000 && base_period == PeriodEnum::secs)
+			if ((counted < 1000 && base_period == PeriodEnum::secs)
 				|| (counted < 1000 * 60 && base_period == PeriodEnum::mins)
 				|| (counted < 1000 * 3600 && base_period == PeriodEnum::hours)
 				|| (counted < 1000 * 86400 && base_period == PeriodEnum::days))
-				return periods.just_a_moment;
+				return chars::append(first, last, periods.just_a_moment);
 
-			StringT str;
+			auto it = first;
 			auto did_eariler = false;
 
 			// build a string representing the time
 			// no need to add white spaces (see namespace time_period_strings)
 			if (days >= 1)
 			{
-				str = boost::lexical_cast<StringT>(days)
-					+ (days != 1 ? periods.days_plural : periods.days_singular);
+				it = chars::append_uint(it, last, days);
+				it = chars::append(it, last, days != 1 ? periods.days_plural : periods.days_singular);
 				did_eariler = true;
 			}
 			if ((!do_cut_smaller_periods || !did_eariler) && base_period <= PeriodEnum::days && hours >= 1)
 			{
-				str += boost::lexical_cast<StringT>(hours)
-					+ (hours != 1 ? periods.hours_plural : periods.hours_singular);
+				it = chars::append_uint(it, last, hours);
+				it = chars::append(it, last, hours != 1 ? periods.hours_plural : periods.hours_singular);
 				did_eariler = true;
 			}
 			if ((!do_cut_smaller_periods || !did_eariler) && base_period <= PeriodEnum::hours && mins >= 1)
 			{
-				str += boost::lexical_cast<StringT>(mins)
-					+ (mins != 1 ? periods.mins_plural : periods.mins_singular);
+				it = chars::append_uint(it, last, mins);
+				it = chars::append(it, last, mins != 1 ? periods.mins_plural : periods.mins_singular);
 				did_eariler = true;
 			}
 			if ((!do_cut_smaller_periods || !did_eariler) && base_period <= PeriodEnum::mins && secs >= 1)
 			{
-				str += boost::lexical_cast<StringT>(secs)
-					+ (secs != 1 ? periods.secs_plural : periods.secs_singular);
+				it = chars::append_uint(it, last, secs);
+				it = chars::append(it, last, secs != 1 ? periods.secs_plural : periods.secs_singular);
 				did_eariler = true;
 			}
 			if ((!do_cut_smaller_periods || !did_eariler) && base_period <= PeriodEnum::secs && msecs >= 1)
 			{
-				str += boost::lexical_cast<StringT>(msecs)
-					+ (msecs != 1 ? periods.msecs_plural : periods.msecs_singular);
+				it = chars::append_uint(it, last, msecs);
+				it = chars::append(it, last, msecs != 1 ? periods.msecs_plural : periods.msecs_singular);
 			}
 
-			return str;
+			return it;
+		}
+
+		template <class StringT, class PeriodStringT, class Rep, class Period>
+		StringT time_duration_to_string(
+			const std::chrono::duration<Rep, Period>&	duration,
+			bool										do_cut_smaller_periods,
+			const TimePeriodStringsT<PeriodStringT>&	periods
+		)
+		{
+			typename StringT::value_type buf[k_time_duration_buffer_size];
+			const auto buf_end = write_time_duration(
+				std::begin(buf), std::end(buf), duration, do_cut_smaller_periods, periods
+			);
+			return StringT(std::begin(buf), buf_end);
 		}
 
 		// a function template of time_duration_to_string for the pointer character types
@@ -0,0 +1,245 @@
+﻿#include "fixture.hpp"
+#include "file_system.hpp"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace text_overseer
+{
+	namespace fixture
+	{
+		using file_io::FileIO;
+
+		namespace
+		{
+			// the answer and the input of a folder only depend on the seed and the folder,
+			// so they're the same whichever thread writes them
+			std::mt19937 folder_rng(const FixtureOptions& options, std::size_t i, std::uint64_t revision)
+			{
+				std::seed_seq seq{
+					options.seed,
+					static_cast<std::uint32_t>(i),
+					static_cast<std::uint32_t>(static_cast<std::uint64_t>(i) >> 32),
+					static_cast<std::uint32_t>(revision)
+				};
+				return std::mt19937(seq);
+			}
+
+			void append_token(std::string& text, std::uint32_t num)
+			{
+				char digits[10];
+				auto it = std::end(digits);
+				do
+				{
+					*--it = static_cast<char>('0' + num % 10);
+					num /= 10;
+				} while (num != 0);
+				text.append(it, std::end(digits));
+			}
+
+			void build_lines(const FixtureOptions& options, std::mt19937& rng, std::string& text)
+			{
+				text.clear();
+				for (std::size_t line = 0; line < options.line_count; line++)
+				{
+					for (std::size_t token = 0; token < options.tokens_per_line; token++)
+					{
+						if (token != 0)
+							text += ' ';
+						append_token(text, rng() % 100000);
+					}
+					text += "\r\n";
+				}
+			}
+
+			// the output is the answer with some lines mismatched; a mismatched line gets an extra token
+			void build_output(
+				const FixtureOptions&	options,
+				std::size_t				i,
+				std::uint64_t			revision,
+				const std::string&		answer,
+				std::string&			output
+			)
+			{
+				auto rng = folder_rng(options, i, revision + 1);
+				std::bernoulli_distribution is_mismatched(std::min(std::max(options.mismatch_rate, 0.0), 1.0));
+
+				output.clear();
+				std::size_t pos = 0;
+				while (pos < answer.size())
+				{
+					const auto line_end = answer.find("\r\n", pos);
+					output.append(answer, pos, line_end - pos);
+					if (is_mismatched(rng))
+						output += " -1";
+					output += "\r\n";
+					pos = line_end + 2;
+				}
+			}
+
+			// the ASCII text in the code units of the encoding
+			void encode_ascii(const std::string& text, FileIO::encoding locale, std::string& bytes)
+			{
+				const auto unit_size = FileIO::code_unit_size(locale);
+				if (unit_size == 1)
+				{
+					bytes = text;
+					return;
+				}
+
+				const auto is_big_endian = FileIO::is_big_endian(locale);
+				bytes.assign(text.size() * unit_size, '\0');
+				for (std::size_t i = 0; i < text.size(); i++)
+					bytes[i * unit_size + (is_big_endian ? unit_size - 1 : 0)] = text[i];
+			}
+
+			bool write_file(const std::wstring& path_str, FileIO::encoding locale, const std::string& bytes)
+			{
+				FileIO file(path_str, locale);
+				if (!file.open(std::ios::out | std::ios::binary))
+					return false;
+				return file.write_all(bytes, bytes.size()); // also writes the BOM of the encoding
+			}
+
+			// runs func(worker index) for every index in [0, thread_count) on a batch, the caller's thread included
+			// the threads are always joined; an exception only ends the worker throwing it
+			// (if some threads couldn't be made, the workers left run in turns)
+			template <class Func>
+			void run_workers(std::size_t thread_count, const Func& func)
+			{
+				file_system::BatchIO workers(thread_count - 1);
+				workers.run_all(thread_count, func);
+			}
+		}
+
+		std::wstring folder_path(const FixtureOptions& options, std::size_t i)
+		{
+			auto num = std::to_wstring(i + 1);
+			if (num.size() < 5)
+				num.insert(0, 5 - num.size(), L'0');
+			return options.root_dir + L"/case" + num;
+		}
+
+		std::size_t generate_fixtures(const FixtureOptions& options)
+		{
+			std::atomic<std::size_t> next_folder{ 0 };
+			std::atomic<std::size_t> failed_count{ 0 };
+
+			run_workers(std::max<std::size_t>(1, std::min(options.thread_count, options.folder_count)), [&](std::size_t) {
+				std::string input, output, answer, bytes; // reused over the folders of the thread
+				for (auto i = next_folder++; i < options.folder_count; i = next_folder++)
+				{
+					const auto folder = folder_path(options, i);
+					boost::system::error_code ec;
+					file_system::filesys::create_directories(folder, ec);
+
+					try
+					{
+						auto rng = folder_rng(options, i, 0);
+						build_lines(options, rng, input);
+						build_lines(options, rng, answer);
+						build_output(options, i, 0, answer, output);
+
+						auto is_written = true;
+						encode_ascii(input, options.locale, bytes);
+						is_written = write_file(folder + L"/input.txt", options.locale, bytes) && is_written;
+						encode_ascii(answer, options.locale, bytes);
+						is_written = write_file(folder + L"/answer.txt", options.locale, bytes) && is_written;
+						encode_ascii(output, options.locale, bytes);
+						is_written = write_file(folder + L"/output.txt", options.locale, bytes) && is_written;
+						if (!is_written)
+							failed_count++;
+					}
+					catch (std::exception&)
+					{
+						failed_count++;
+					}
+				}
+			});
+
+			return failed_count;
+		}
+
+		ChurnStats run_churn(
+			const FixtureOptions&		options,
+			double						rewrites_per_sec,
+			std::chrono::milliseconds	duration,
+			const std::atomic<bool>*	cancel_flag,
+			bool						do_check_stamps
+		)
+		{
+			using clock = std::chrono::steady_clock;
+
+			ChurnStats stats;
+			if (rewrites_per_sec <= 0.0 || options.folder_count == 0)
+				return stats;
+
+			const auto start_time = clock::now();
+			const auto end_time = start_time + duration;
+			const auto thread_count = std::max<std::size_t>(1, std::min(options.thread_count, options.folder_count));
+			std::atomic<std::uint64_t> rewrite_count{ 0 };
+			std::atomic<std::uint64_t> detected_count{ 0 };
+
+			// the stamp of each folder is only touched by the thread of its shard
+			std::vector<file_system::FileStamp> stamps;
+			if (do_check_stamps)
+			{
+				for (std::size_t i = 0; i < options.folder_count; i++)
+					stamps.push_back(file_system::stat_file(folder_path(options, i) + L"/output.txt").stamp);
+			}
+
+			// the rewrites are scheduled on one timeline, so the rate holds however many threads there are;
+			// the folders are sharded over the threads (i % thread_count), so no two threads truncate
+			// the same output file at once
+			run_workers(thread_count, [&](std::size_t shard) {
+				std::string answer, output, bytes;
+				for (std::uint64_t k = 0; ; k++)
+				{
+					if (k % options.folder_count % thread_count != shard)
+						continue;
+					const auto due_time = start_time + std::chrono::duration_cast<clock::duration>(
+						std::chrono::duration<double>(k / rewrites_per_sec)
+					);
+					if (due_time >= end_time)
+						return;
+					std::this_thread::sleep_until(due_time);
+					if (cancel_flag != nullptr && *cancel_flag)
+						return;
+
+					const auto i = static_cast<std::size_t>(k % options.folder_count);
+					try
+					{
+						auto rng = folder_rng(options, i, 0);
+						build_lines(options, rng, answer); // the input lines go first
+						build_lines(options, rng, answer);
+						build_output(options, i, k + 1, answer, output);
+
+						encode_ascii(output, options.locale, bytes);
+						const auto path_str = folder_path(options, i) + L"/output.txt";
+						if (!write_file(path_str, options.locale, bytes))
+							continue;
+						rewrite_count++;
+						if (do_check_stamps)
+						{
+							const auto result = file_system::stat_file(path_str);
+							if (!result.ec && result.stamp != stamps[i])
+								detected_count++;
+							stamps[i] = result.stamp;
+						}
+					}
+					catch (std::exception&)
+					{
+						// do nothing
+					}
+				}
+			});
+
+			stats.rewrite_count = rewrite_count;
+			stats.detected_count = detected_count;
+			stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time);
+			return stats;
+		}
+	}
+}
\ No newline at end of file
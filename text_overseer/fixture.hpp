@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "file_io.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace text_overseer
+{
+	// generates test case folders to put a reproducible load on the overseer
+	namespace fixture
+	{
+		struct FixtureOptions
+		{
+			std::wstring				root_dir{ L"fixtures" };
+			std::size_t					folder_count{ 100 };
+			std::size_t					line_count{ 100 };
+			std::size_t					tokens_per_line{ 8 }; // each token is a number of up to 5 digits
+			file_io::FileIO::encoding	locale{ file_io::FileIO::encoding::utf8_no_bom };
+			double						mismatch_rate{ 0.0 }; // the rate of the output lines different from the answer
+			std::uint32_t				seed{ 1 };
+			std::size_t					thread_count{ 4 };
+		};
+
+		struct ChurnStats
+		{
+			std::uint64_t				rewrite_count{ 0 };
+			std::uint64_t				detected_count{ 0 }; // the rewrites that changed the file stamp
+			std::chrono::milliseconds	elapsed{ 0 };
+		};
+
+		// the folder of the i-th case under the root directory
+		std::wstring folder_path(const FixtureOptions& options, std::size_t i);
+
+		// writes input.txt, output.txt and answer.txt into each folder, on the threads of the options
+		// the text is ASCII, so it reads the same in every encoding
+		// @returns the number of the folders failed to be written
+		std::size_t generate_fixtures(const FixtureOptions& options);
+
+		// rewrites the output files of the generated folders at the target rate, until the duration passes or
+		// the cancel flag is set; each rewrite has new mismatched lines, so it changes the line diff too
+		// if do_check_stamps, it takes the stamp after each rewrite and counts the ones that differ from
+		// the stamp of the folder's last rewrite; a detected count less than the rewrite count means
+		// some rewrites can't be told apart by the stamps
+		ChurnStats run_churn(
+			const FixtureOptions&		options,
+			double						rewrites_per_sec,
+			std::chrono::milliseconds	duration,
+			const std::atomic<bool>*	cancel_flag = nullptr,
+			bool						do_check_stamps = false
+		);
+	}
+}
\ No newline at end of file
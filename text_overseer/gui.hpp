@@ -2,9 +2,18 @@
 
 #include "file_system.hpp"
 #include "file_io.hpp"
+#include "line_diff.hpp"
+#include "report.hpp"
 
 #include <array>
-#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <nana/gui.hpp>
 #include <nana/gui/msgbox.hpp>
 #include <nana/gui/place.hpp>
@@ -15,6 +24,7 @@
 #include <nana/gui/widgets/menu.hpp>
 #include <nana/gui/widgets/panel.hpp>
 #include <nana/gui/widgets/picture.hpp>
+#include <nana/gui/widgets/scroll.hpp>
 #include <nana/gui/widgets/tabbar.hpp>
 #include <nana/gui/widgets/textbox.hpp>
 
@@ -22,23 +32,118 @@ namespace text_overseer
 {
 	namespace gui
 	{
-		constexpr int k_max_count_read_file = 3;
-		constexpr int k_max_count_try_to_update_widget = 5;
 		constexpr int k_max_count_check_last_file_write = 5;
 		constexpr int k_ms_gui_timer_interval = 20;
 		constexpr int k_ms_update_label_state_interval = 100;
+		constexpr int k_ms_change_quiet_period = 200; // a changed file is reloaded after it's quiet for it
+		constexpr int k_ms_change_max_latency = 1000; // or after it, even if the file keeps changing
+		constexpr int k_tabbar_color_levels = 32; // the number of distinct colors in a tabbar animation
+		constexpr std::size_t k_max_live_io_tab_pages = 8; // the pages more than it are evicted by LRU
+		constexpr std::size_t k_export_cases_per_slice = 32; // the cases fingerprinted in a batch while exporting
+		constexpr int k_ms_export_budget_per_tick = 40; // the time the timer spends on exporting in a tick
+		constexpr double k_min_sure_detection_confidence = 0.9; // a detected encoding less sure is marked as guessed
+		constexpr std::size_t k_max_kept_buffer_size = 1 << 20; // the bytes of a buffer kept for the next read or write
+		constexpr bool k_do_sync_when_saving = true; // flush the saved file to the disk before replacing
+
+		// the lines of "input output [answer]" filename patterns; the default ones are used without it
+		constexpr wchar_t k_io_file_patterns_filename[] = L"io_file_patterns.txt";
+
+		// the report of all the cases exported from the dashboard; see report::write_report()
+		constexpr wchar_t k_report_filename[] = L"text_overseer_report.bin";
 
 		// the postfix for the label when the input file is edited
 		constexpr std::array<char, 24> k_label_postfix_edited{ " <color=0xff4500>(*)</>" };
 
 		const nana::color k_line_num_default_color = nana::colors::light_goldenrod_yellow;
 
+		// the names of FileIO::encoding, in its order
+		constexpr std::array<const char*, 8> k_encoding_names{
+			u8"자동", "ANSI", "UTF-8", u8"서명 없는 UTF-8", "UTF-16LE", "UTF-16BE", "UTF-32LE", "UTF-32BE"
+		};
+
+		// a central frame scheduler for the widgets' periodic work
+		// every task shares one timer, which only runs while some task is dirty;
+		// the tasks of a hidden or not enabled owner window are skipped until it gets woken again
+		class FrameScheduler
+		{
+		public:
+			using task_id = std::size_t;
+			using task_func = std::function<bool()>; // returns true to be serviced on the next frame too
+
+			FrameScheduler();
+
+			FrameScheduler(const FrameScheduler& src) = delete;
+			FrameScheduler& operator=(const FrameScheduler& rhs) = delete;
+
+			task_id add_task(nana::window owner, task_func func);
+			void remove_task(task_id id) noexcept;
+			void mark_dirty(task_id id) noexcept;
+			void wake(nana::window owner) noexcept; // marks all the tasks of the owner window dirty
+
+		private:
+			static constexpr task_id k_no_task = static_cast<task_id>(-1);
+
+			struct Task
+			{
+				nana::window	owner;
+				task_func		func;
+				bool			is_dirty;
+				bool			is_removed;
+			};
+
+			bool _is_owner_shown(nana::window owner) const noexcept;
+			void _tick() noexcept;
+
+			nana::timer				timer_;
+			std::deque<Task>		tasks_; // indexed by task_id; a deque keeps references valid on add_task()
+			std::vector<task_id>	free_ids_;
+			std::vector<task_id>	dirty_ids_;
+			std::vector<task_id>	servicing_ids_; // swapped with dirty_ids_ on every tick
+			task_id					servicing_id_{ k_no_task };
+		};
+
+		// a single animation driver for the tabbar highlight effects
+		// the active animations are kept as a struct of arrays and all of them are stepped in one frame;
+		// a tab color is only set again when its blending level has visibly changed
+		class TabbarColorAnimator
+		{
+		public:
+			TabbarColorAnimator(nana::tabbar<std::string>& tabbar_widget, FrameScheduler& frame_scheduler);
+			~TabbarColorAnimator();
+
+			TabbarColorAnimator(const TabbarColorAnimator& src) = delete;
+			TabbarColorAnimator& operator=(const TabbarColorAnimator& rhs) = delete;
+
+			void start(std::size_t pos); // does nothing if the tab is already animating
+			void clear() noexcept;
+			std::size_t size() const noexcept { return positions_.size(); }
+
+		private:
+			static double _color_level(unsigned int time) noexcept;
+			bool _step() noexcept;
+
+			nana::tabbar<std::string>*	tabbar_ptr_{ nullptr };
+			FrameScheduler*				frame_scheduler_ptr_{ nullptr };
+			FrameScheduler::task_id		task_id_;
+
+			// the active animations (struct of arrays)
+			std::vector<std::size_t>	positions_;
+			std::vector<unsigned int>	elapsed_times_;
+			std::vector<int>			applied_levels_;
+
+			std::vector<bool>			is_animating_; // indexed by the tab position
+		};
+
 		class IOFilesTabPage;
 
 		class AbstractBoxUnit : public nana::panel<false>
 		{
 		public:
 			AbstractBoxUnit(IOFilesTabPage& parent_tab_page);
+			virtual ~AbstractBoxUnit();
+
+			// requests a frame; the line numbers and the edited state will be checked on it
+			void mark_dirty() noexcept;
 
 			void refresh_textbox_line_num() noexcept
 			{
@@ -48,7 +153,7 @@ namespace text_overseer
 			virtual bool update_label_state() noexcept = 0;
 
 		protected:
-			virtual nana::color _line_num_color(unsigned int) noexcept
+			virtual nana::color _line_num_color(std::uint64_t) noexcept
 			{
 				return k_line_num_default_color;
 			}
@@ -56,6 +161,10 @@ namespace text_overseer
 			void _make_textbox_line_num() noexcept;
 			virtual void _post_textbox_edited(bool is_edited) noexcept { }
 
+			// sets the caption of lab_state_ only if the text is changed
+			void _set_state_caption(const char* first, const char* last);
+			void _set_state_caption(const char* str) { _set_state_caption(str, str + std::strlen(str)); }
+
 			virtual void _reset_textbox_edited() noexcept
 			{
 				refresh_textbox_line_num();
@@ -72,29 +181,62 @@ namespace text_overseer
 			IOFilesTabPage* tab_page_ptr_{ nullptr };
 
 		private:
+			bool _service_frame() noexcept;
+			bool _is_cursor_on_textbox() const noexcept;
+			std::size_t _textbox_first_line() const;
+			void _make_textbox_dirty_events() noexcept;
 			void _make_textbox_popup_menu();
 
-			nana::timer gui_refresh_timer_;
+			FrameScheduler::task_id frame_task_id_;
+			bool is_marked_dirty_{ false }; // by an event since the last frame
+			bool is_following_scroll_{ false }; // the last frame asked for the next one, to follow the scrollbar
+			std::size_t drawn_first_line_{ 0 }; // the first line of the text the line numbers were drawn for
+			std::string lab_state_text_; // the caption of lab_state_, to skip setting the same one
 		};
 
-		class AnswerTextBoxUnit : public AbstractBoxUnit
+		// a file read by AbstractIOFileBoxUnit::load_file(), which may run on a worker thread
+		// it's published to the GUI thread through an atomic shared pointer and isn't changed while published,
+		// so neither thread waits for the other; once shown, it's handed back to be reused by the next load
+		struct LoadedFile
 		{
-		public:
-			explicit AnswerTextBoxUnit(IOFilesTabPage& parent_tab_page);
+			file_io::TextBuffers buffers; // bytes: the raw file, wide: the text for the textbox
+			file_io::FileIO::encoding locale{ file_io::FileIO::encoding::unknown };
+			newline_style newline{ newline_style::cr_lf }; // of the file, which it's saved in
+			double detection_confidence{ 1.0 }; // of the encoding, if it was detected without a BOM
+			std::chrono::high_resolution_clock::duration load_duration{};
+			std::string error; // empty if it was loaded
+			std::shared_ptr<std::string> text; // UTF-8, only for OutputFileBoxUnit
+			std::shared_ptr<const line_diff::SharedAnswer> answer; // only for AnswerFileBoxUnit
+
+			// keeps what the next load reuses; a buffer or a text larger than max_kept_bytes is freed
+			void trim(std::size_t max_kept_bytes) noexcept
+			{
+				if (text && text->capacity() > max_kept_bytes)
+					text.reset();
+				answer.reset();
+				buffers.trim(max_kept_bytes);
+			}
+		};
 
-			void label_caption(const std::string &str) { lab_state_.caption(str); }
-			void label_caption(std::string &&str) { lab_state_.caption(std::move(str)); }
-			void reset_line_count_of_file() { file_line_count_if_shorter_ = 0; }
-			void set_line_count_of_file(std::size_t count) { file_line_count_if_shorter_ = count; }
-			std::string textbox_caption() { return textbox_.caption(); }
-			bool update_label_state() noexcept override { return false; }
+		// the heap bytes held by a tab page, by what holds them
+		// the textboxes keep their own copies, so their size is estimated by the text shown
+		struct MemoryUsage
+		{
+			std::size_t widget_text{ 0 };	// in the textboxes
+			std::size_t shared_text{ 0 };	// the file contents shared with the line diff, divided by the holders
+			std::size_t buffers{ 0 };		// kept to be reused by the next load or write
+			std::size_t line_diff{ 0 };		// the answer indexes and the line results
 
-		protected:
-			virtual nana::color _line_num_color(unsigned int num) noexcept override;
-			virtual void _post_textbox_edited(bool is_edited) noexcept override;
+			std::size_t total() const noexcept { return widget_text + shared_text + buffers + line_diff; }
 
-		private:
-			std::size_t file_line_count_if_shorter_{ 0 }; // will be used if not 0 and the output file is shorter
+			MemoryUsage& operator+=(const MemoryUsage& rhs) noexcept
+			{
+				widget_text += rhs.widget_text;
+				shared_text += rhs.shared_text;
+				buffers += rhs.buffers;
+				line_diff += rhs.line_diff;
+				return *this;
+			}
 		};
 
 		class AbstractIOFileBoxUnit : public AbstractBoxUnit
@@ -102,9 +244,30 @@ namespace text_overseer
 		public:
 			AbstractIOFileBoxUnit(IOFilesTabPage& parent_tab_page);
 
-			virtual bool read_file();
-			virtual bool update_label_state() noexcept override;
+			const std::wstring& file_path() const noexcept { return file_.filename_wstring(); }
+			file_io::FileIO::encoding file_locale() const noexcept { return file_.locale(); }
+
+			bool read_file(); // load_file() and then show_loaded_file()
+
+			// reads and decodes the file into a new LoadedFile and publishes it, without touching any widget
+			// it can run on a worker thread; a file published but not shown yet is superseded by the newer one
+			// an error is kept and reported by show_loaded_file()
+			bool load_file() noexcept;
+
+			// takes the LoadedFile published and shows it; it must be called on the GUI thread
+			virtual bool show_loaded_file();
+			bool has_loaded_file() const noexcept { return std::atomic_load(&loaded_file_) != nullptr; }
+
+			virtual bool update_label_state() noexcept override; // stats the file by itself
+			bool update_label_state(const file_system::FileStatResult& stat) noexcept;
+			bool is_file_changed(const file_system::FileStatResult& stat) const noexcept;
+
+			// the stat of the file shown; a change held back by the coalescer is hidden behind it
+			file_system::FileStatResult shown_stat() const noexcept;
 			bool is_same_file(const std::wstring& path_str) const noexcept;
+			bool has_file() const noexcept { return !file_.filename_wstring().empty(); }
+
+			virtual void add_memory_usage(MemoryUsage& usage) const noexcept;
 
 			template <class StringT>
 			void register_file(StringT&& file_path) noexcept
@@ -113,19 +276,52 @@ namespace text_overseer
 			}
 
 		protected:
+			// called by load_file() after the file was decoded into loaded.buffers.wide, before it's published
+			// it may run on a worker thread, so it must not touch any widget
+			virtual void _post_load_file(LoadedFile&) { }
+
+			// called by show_loaded_file() after the text is shown, on the GUI thread
+			virtual void _post_show_file(LoadedFile&) { }
+
+			// sets the encoding of the file, for both the writes and the next loads
+			void _set_file_locale(file_io::FileIO::encoding locale) noexcept
+			{
+				file_.locale(locale);
+				load_locale_ = locale;
+			}
+
+			// sets the option of combo_locale_ without taking it as the user's choice
+			void _show_file_locale(file_io::FileIO::encoding locale);
+
 			virtual bool _write_file() = 0;
 
+			// logs the throughput of a read or write when debugging is started
+			void _report_bandwidth(
+				const char*									job_name,
+				std::size_t									byte_size,
+				std::chrono::high_resolution_clock::duration	duration
+			) noexcept;
+
 			nana::button btn_reload_{ *this, u8"다시 읽기" };
 			nana::button btn_folder_{ *this };
 			nana::combox combo_locale_{ *this, u8"파일 인코딩" };
 
-			file_io::FileIO file_;
-			std::mutex file_mutex_;
-			file_system::TimePointOfSys last_write_time_;
+			file_io::FileIO file_; // only used on the GUI thread; load_file() opens the file on its own
+			file_io::TextBuffers io_buffers_; // for the writes of file_; trimmed after each write
+			file_system::FileStamp stamp_; // of the file shown
 			bool last_write_time_is_vaild_{ false };
 
 		private:
-			bool _check_last_write_time() noexcept;
+			file_system::FileStatResult _stat_file() const noexcept; // retries on an error
+			bool _check_last_write_time(const file_system::FileStatResult& stat) noexcept;
+
+			// the handoff from load_file() to show_loaded_file(); they're only accessed by std::atomic_*()
+			std::shared_ptr<LoadedFile> loaded_file_; // published, not shown yet
+			std::shared_ptr<LoadedFile> spare_loaded_file_; // shown, to be reused by the next load
+			std::atomic<file_io::FileIO::encoding> load_locale_{ file_io::FileIO::encoding::system }; // of file_
+			bool is_showing_file_locale_{ false };
+			bool is_file_locale_guessed_{ false }; // detected with a low confidence, and not chosen by the user
+			std::size_t shown_text_size_{ 0 }; // the bytes of the wide text given to the textbox
 			void _make_events() noexcept;
 		};
 
@@ -134,10 +330,10 @@ namespace text_overseer
 		public:
 			explicit InputFileBoxUnit(IOFilesTabPage& parent_tab_page);
 
-			virtual bool read_file() override;
+			bool is_edited() const noexcept { return did_post_edited_; } // not saved yet
 
 		protected:
-			virtual nana::color _line_num_color(unsigned int) noexcept override
+			virtual nana::color _line_num_color(std::uint64_t) noexcept override
 			{
 				return nana::colors::light_blue;
 			}
@@ -149,11 +345,7 @@ namespace text_overseer
 			nana::button btn_save_{ *this, u8"저장" };
 
 		private:
-			// call it when failed to write; the file_ must be opened for writing
-			void _restore_opened_file_to_utf8();
-
 			bool did_post_edited_{ false };
-			std::string text_backup_u8_;
 		};
 
 		class OutputFileBoxUnit : public AbstractIOFileBoxUnit
@@ -161,72 +353,213 @@ namespace text_overseer
 		public:
 			explicit OutputFileBoxUnit(IOFilesTabPage& parent_tab_page);
 
-			virtual bool read_file() override;
+			virtual bool show_loaded_file() override;
+
+			// @returns the status and the line counts; see line_diff::diff_lines()
+			line_diff::LineDiffResult line_diff_between_answer(const line_diff::AnswerIndex& answer);
 
-			// a simple enum class for line_diff_between_answer()'s return value
-			enum class line_diff_sign : int
+			// the results of the last line diff, or nullptr if it wasn't compared
+			const line_diff::LineDiffBits* line_diff_results() const noexcept
 			{
-				done = 0,
-				error = -1,
-			};
+				return did_line_diff_ ? &line_diff_results_ : nullptr;
+			}
 
-			// @returns done:	 0
-			//          error:	-1
-			//			the file is shorter than answer: the line count of the output file
-			int line_diff_between_answer(const std::string& answer);
+			virtual void add_memory_usage(MemoryUsage& usage) const noexcept override;
 
 		protected:
-			virtual nana::color _line_num_color(unsigned int num) noexcept override;
+			virtual nana::color _line_num_color(std::uint64_t num) noexcept override;
+			virtual void _post_load_file(LoadedFile& loaded) override;
+			virtual void _post_show_file(LoadedFile& loaded) override;
 			virtual bool _write_file() noexcept override { return false; }
 
 		private:
 			bool did_line_diff_{ false };
-			std::vector<bool> line_diff_results_;
+			line_diff::LineDiffBits line_diff_results_;
+			std::shared_ptr<std::string> shown_text_; // the file shown in UTF-8, compared without a copy
+		};
+
+		// the answer is read from the answer file if there's one, or else typed by the user
+		// the text read is shared through the answer cache, so identical answer files are tokenized once
+		class AnswerFileBoxUnit : public AbstractIOFileBoxUnit
+		{
+		public:
+			explicit AnswerFileBoxUnit(IOFilesTabPage& parent_tab_page);
+
+			virtual bool show_loaded_file() override;
+
+			void label_caption(const std::string &str) { lab_diff_.caption(str); }
+			void label_caption(std::string &&str) { lab_diff_.caption(std::move(str)); }
+			void reset_line_count_of_file() { file_line_count_if_shorter_ = 0; }
+			void set_line_count_of_file(std::uint64_t count) { file_line_count_if_shorter_ = count; }
+
+			// the answer tokenized once; it's built again only after the answer is edited
+			const line_diff::AnswerIndex& answer_index();
+
+			// an answer typed by the user has no file to be watched
+			void label_no_file();
+			bool is_typed() const noexcept { return is_typed_; } // edited by the user since it was loaded
+
+			virtual void add_memory_usage(MemoryUsage& usage) const noexcept override;
+
+		protected:
+			virtual nana::color _line_num_color(std::uint64_t num) noexcept override;
+			virtual void _post_load_file(LoadedFile& loaded) override;
+			virtual void _post_show_file(LoadedFile& loaded) override;
+			virtual void _post_textbox_edited(bool is_edited) noexcept override;
+			virtual bool _write_file() noexcept override { return false; } // the answer file is never written
+
+		private:
+			nana::label lab_diff_{ *this };
+
+			std::uint64_t file_line_count_if_shorter_{ 0 }; // will be used if not 0 and the output file is shorter
+			std::shared_ptr<const line_diff::SharedAnswer> shared_answer_; // the answer file shown, if not edited
+			std::string typed_answer_; // the edited answer, which answer_index_ points into
+			line_diff::AnswerIndex answer_index_; // of the edited answer
+			bool answer_index_is_valid_{ false };
+			bool is_typed_{ false };
+		};
+
+		enum class case_verdict : char
+		{
+			unknown,	// not compared, or the files were changed since
+			passed,		// every line is the same as the answer
+			failed
 		};
 
 		class IOFilesTabPage : public nana::panel<true>
 		{
 		public:
-			IOFilesTabPage(nana::window wd);
+			static constexpr std::size_t k_file_box_count = 3;
+
+			IOFilesTabPage(nana::window wd, FrameScheduler& frame_scheduler, line_diff::AnswerCache& answer_cache);
+
+			FrameScheduler& frame_scheduler() noexcept { return *frame_scheduler_ptr_; }
+			line_diff::AnswerCache& answer_cache() noexcept { return *answer_cache_ptr_; }
 
-			bool is_same_files(
-				const std::wstring& input_filename,
-				const std::wstring& output_filename
-			) const noexcept
+			// the text that would be lost if the page were destroyed
+			bool has_unsaved_text() const noexcept
 			{
-				return input_box_.is_same_file(input_filename) && output_box_.is_same_file(output_filename);
+				return input_box_.is_edited() || answer_box_.is_typed();
 			}
 
 			void output_box_line_diff();
+			case_verdict verdict() const noexcept; // by the last line diff
+			const line_diff::LineDiffResult& last_diff_result() const noexcept { return last_diff_result_; }
+			const line_diff::LineDiffBits* line_diff_results() const noexcept { return output_box_.line_diff_results(); }
+			file_io::FileIO::encoding input_locale() const noexcept { return input_box_.file_locale(); }
+			MemoryUsage memory_usage() const noexcept;
 
-			void register_files(std::wstring input_filename, std::wstring output_filename)
+			void register_files(const file_system::IOFilePaths& file_paths)
 			{
-				input_box_.register_file(input_filename);
-				output_box_.register_file(output_filename);
+				input_box_.register_file(file_paths.input);
+				output_box_.register_file(file_paths.output);
+				answer_box_.register_file(file_paths.answer);
+				if (!answer_box_.has_file())
+					answer_box_.label_no_file();
 			}
 
 			void reload_files()
 			{
 				input_box_.read_file() || output_box_.read_file();
+				if (answer_box_.has_file())
+					answer_box_.read_file();
+			}
+
+			// adds the input, the output and the answer file box unit, in this order
+			void collect_io_file_boxes(std::vector<AbstractIOFileBoxUnit*>& boxes)
+			{
+				boxes.push_back(&input_box_);
+				boxes.push_back(&output_box_);
+				boxes.push_back(&answer_box_);
 			}
 
-			bool update_io_file_box_state() noexcept
+			// @param stats: the stats of the files of collect_io_file_boxes(), in the same order
+			bool update_io_file_box_state(const file_system::FileStatResult* stats) noexcept
 			{
-				auto input_state = input_box_.update_label_state();
-				auto output_state = output_box_.update_label_state();
-				return input_state || output_state;
+				auto input_state = input_box_.update_label_state(stats[0]);
+				auto output_state = output_box_.update_label_state(stats[1]);
+				auto answer_state = answer_box_.has_file() && answer_box_.update_label_state(stats[2]);
+				return input_state || output_state || answer_state;
 			}
 
 		protected:
+			FrameScheduler* frame_scheduler_ptr_{ nullptr }; // must be initialized before the box units
+			line_diff::AnswerCache* answer_cache_ptr_{ nullptr };
+			line_diff::LineDiffResult last_diff_result_;
+
 			nana::place place_{ *this };
 
 			InputFileBoxUnit input_box_{ *this };
 			OutputFileBoxUnit output_box_{ *this };
-			AnswerTextBoxUnit answer_box_{ *this };
+			AnswerFileBoxUnit answer_box_{ *this };
+		};
+
+		// a tab of a test case; it's only a descriptor until it's activated first,
+		// and its page is evicted back to the descriptor when it's the least recently activated one
+		struct IOTabDescriptor
+		{
+			bool is_same_files(const file_system::IOFilePaths& paths) const noexcept;
+
+			// @param stats: the stats of the files in the order of IOFilesTabPage::collect_io_file_boxes()
+			// @returns true if any file was changed since the last stats
+			bool update_stamps(const file_system::FileStatResult* stats) noexcept;
+
+			file_system::IOFilePaths file_paths;
+			std::array<file_system::FileStamp, IOFilesTabPage::k_file_box_count> stamps{};
+			std::array<file_system::ChangeCoalescer, IOFilesTabPage::k_file_box_count> change_coalescers;
+			std::shared_ptr<IOFilesTabPage> page; // null if it's not materialized
+
+			// the line results of the page when it was evicted, for the report; cleared when a file changes
+			line_diff::LineDiffResult evicted_diff_result;
+			std::vector<std::uint64_t> evicted_diff_runs; // see line_diff::LineDiffBits::to_runs()
+			std::uint64_t last_activated{ 0 }; // the activation count when it was activated last
+			bool is_found{ true }; // false while a search hasn't found its files again
+		};
+
+		// the dashboard model of all the test cases, as a struct of arrays indexed by the tab position
+		// the file watcher and the line diffs update it, and the dashboard only reads it to draw
+		struct IOCaseTable
+		{
+			void push_back(std::string name);
+			void erase(std::size_t pos);
+			std::size_t size() const noexcept { return names.size(); }
+
+			std::vector<std::string>					names;
+			std::vector<file_system::TimePointOfSys>	last_changes; // the latest write time of the files
+			std::vector<std::uint64_t>					input_sizes;
+			std::vector<std::uint64_t>					output_sizes;
+			std::vector<file_io::FileIO::encoding>		input_encodings; // unknown until the page reads it
+			std::vector<case_verdict>					verdicts;
 		};
 
 		class MainWindow;
 
+		// a virtualized list of all the test cases; only the rows in view are drawn
+		class DashboardBox : public nana::panel<true>
+		{
+		public:
+			DashboardBox(MainWindow& parent_main_window, const IOCaseTable& table);
+
+			void update_rows() noexcept; // call it after the rows are added or erased
+			void show_export_progress(std::size_t done, std::size_t total); // done == total ends it
+			void refresh() noexcept { nana::API::refresh_window(canvas_); }
+
+		private:
+			static constexpr unsigned int k_row_height = 20;
+
+			void _draw(nana::paint::graphics& graph) const;
+			std::size_t _row_at(int y) const noexcept; // size() of the table if there's no row
+			std::size_t _visible_row_count() const noexcept;
+
+			nana::place place_{ *this };
+			nana::panel<true> canvas_{ *this };
+			nana::scroll<true> scroll_{ *this };
+			nana::button btn_export_{ *this, u8"결과 내보내기" };
+
+			const IOCaseTable* table_ptr_{ nullptr };
+			MainWindow* main_window_ptr_{ nullptr };
+		};
+
 		class WelcomeBox : public nana::panel<true>
 		{
 		public:
@@ -249,28 +582,53 @@ namespace text_overseer
 			MainWindow* main_window_ptr_{ nullptr };
 		};
 
+		// the startup milestones(the first frame and all the tabs) are logged if it's enabled
+		struct StartupTrace
+		{
+			bool is_enabled{ false };
+			std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
+		};
+
 		class MainWindow : public nana::form
 		{
 		public:
-			MainWindow();
+			explicit MainWindow(const StartupTrace& startup_trace = StartupTrace{});
 
+			// writes the fingerprints of the files and the line results of all the cases into a report file
+			// the cases are snapshot now, and their files are fingerprinted by the timer, a slice at a time
+			void export_report() noexcept;
 			void search_io_files() noexcept;
+			void show_io_tab(std::size_t pos) noexcept; // leaves the dashboard
 
 		private:
-			void _create_io_tab_page(
-				std::string tab_name_u8,
-				std::wstring input_filename,
-				std::wstring output_filename
-			) noexcept;
+			void _activate_io_tab(std::size_t pos) noexcept; // materializes its page if needed
+			void _create_io_tab(std::string tab_name_u8, const file_system::IOFilePaths& file_paths) noexcept;
 			void _easter_egg_logo() noexcept;
+			void _evict_io_tab_pages(std::size_t active_pos) noexcept;
+			static std::wstring _io_tab_key(const file_system::IOFilePaths& file_paths); // see io_tab_positions_
+			static std::string _io_tab_name(const file_system::IOFilePaths& file_paths);
+			std::vector<file_system::IOFilePatterns> _load_io_file_patterns() noexcept;
+			void _load_logo() noexcept;
 			void _make_events() noexcept;
 			void _make_io_tabs_not_enabled_except_one(std::size_t pos) noexcept;
 			void _make_timer_io_tab_state() noexcept;
-			void _make_tabbar_color_animation(std::size_t pos) noexcept;
-			void _remove_tabbar_color_animation(std::size_t pos) noexcept;
+			void _materialize_io_tab_page(std::size_t pos);
+			void _report_memory_usage() noexcept; // of the live pages, when debugging is started
+			void _show_dashboard(bool is_shown) noexcept;
+			void _step_export_report() noexcept; // fingerprints the files of the export for a tick
+			void _finish_export_report(bool is_written) noexcept;
+			void _show_welcome_box(bool is_shown) noexcept;
+			void _take_found_io_files() noexcept; // adds the tabs found by the search so far
+			void _trace_startup(const char* milestone) noexcept;
+			void _update_io_case(std::size_t pos, bool is_changed) noexcept;
+			void _update_io_tab_states() noexcept;
+
+			StartupTrace startup_trace_;
+			bool did_trace_all_tabs_{ false };
 
 			nana::place place_{ *this };
 			nana::picture pic_logo_{ *this };
+			bool is_logo_loaded_{ false };
 
 			nana::label lab_title_{
 				*this,
@@ -279,25 +637,50 @@ namespace text_overseer
 			nana::label lab_description_{
 				*this,
 				u8"이 프로그램은 이 프로그램이 위치한 폴더와 하위 폴더에 있는 "
-				u8"<blue>input.txt</>와 <blue>output.txt</>의 변동 여부를 실시간으로 감시합니다.\n"
+				u8"<blue>input.txt</>와 <blue>output.txt</>, <blue>answer.txt</>의 변동 여부를 실시간으로 감시합니다.\n"
 				u8"사용한 라이브러리: <green size=10>Nana C++ GUI Library</>, <green size=10>Boost C++ Libraries</>"
 			};
 			nana::button btn_refresh_{ *this, u8"입출력 파일 다시 찾기" };
+			nana::button btn_dashboard_{ *this, u8"대시보드 보기" };
+
+			FrameScheduler frame_scheduler_; // must outlive the io tab pages
+			line_diff::AnswerCache answer_cache_; // must outlive the io tab pages too
 
 			nana::tabbar<std::string> tabbar_{ *this };
-			std::mutex io_tab_mutex_;
-			std::vector<std::shared_ptr<IOFilesTabPage>> io_tab_pages_;
+			bool is_changing_io_tabs_{ false }; // all the io tabs are only touched on the GUI thread
+			std::vector<IOTabDescriptor> io_tabs_;
+			std::uint64_t io_tab_activation_count_{ 0 };
 			nana::timer timer_io_tab_state_;
 
+			// the search runs on its own thread, and the timer takes what it found so far
+			file_system::AsyncFileSearch io_file_search_;
+			bool is_searching_io_files_{ false };
+			bool do_notify_no_io_files_{ false }; // whether to show a message box if the search finds nothing
+			std::vector<file_system::IOFilePaths> found_io_files_;
+			std::vector<file_system::FilePathErrorCode> found_path_ecs_;
+			std::unordered_map<std::wstring, std::size_t> io_tab_positions_; // the tabs before the search, by the key
+
+			// the files of all the io tabs are stat in a batch, and then the changed ones are loaded in a batch
+			file_system::BatchIO batch_io_;
+			std::vector<AbstractIOFileBoxUnit*> watched_boxes_; // null for the files of a tab not materialized
+			std::vector<const std::wstring*> watched_paths_;
+			std::vector<file_system::FileStatResult> watched_stats_;
+			std::vector<AbstractIOFileBoxUnit*> changed_boxes_;
+
+			// the report being exported; it doesn't refer to the io tabs, which may change meanwhile
+			std::vector<report::CaseSnapshot> export_cases_;
+			std::vector<file_system::IOFilePaths> export_file_paths_;
+			std::size_t export_next_case_{ 0 };
+			bool is_exporting_report_{ false };
+
 			WelcomeBox welcome_box_{ *this }; // it will be shown when there's no IO tab page
+			bool is_welcome_box_shown_{ false };
 
-			struct TabbarColorAnimation
-			{
-				std::shared_ptr<nana::timer> timer_ptr;
-				unsigned int elapsed_time;
-			};
+			IOCaseTable io_cases_; // indexed by the tab position, like io_tabs_
+			DashboardBox dashboard_{ *this, io_cases_ };
+			bool is_dashboard_shown_{ false };
 
-			std::vector<TabbarColorAnimation> tabbar_color_animations_;
+			TabbarColorAnimator tabbar_color_animator_{ tabbar_, frame_scheduler_ };
 		};
 	}
 }
\ No newline at end of file
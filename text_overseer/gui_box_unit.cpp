@@ -1,15 +1,10 @@
-﻿// std::copy() for char* in boost library(string.hpp) causes an error by MS compliers
-#ifdef _MSC_VER
-#define _SCL_SECURE_NO_WARNINGS
-#endif
-
-#include "gui.hpp"
+﻿#include "gui.hpp"
 #include "encoding.hpp"
 #include "error_handler.hpp"
 
+#include <algorithm>
 #include <iomanip>
-#include <boost/algorithm/string.hpp>
-#include <boost/utility/string_view.hpp>
+#include <iterator>
 
 using namespace nana;
 
@@ -34,16 +29,23 @@ namespace text_overseer
 			API::eat_tabstop(textbox_, false);
 
 			_make_textbox_popup_menu();
+			_make_textbox_dirty_events();
 
-			// make gui refresh timer
-			gui_refresh_timer_.interval(k_ms_gui_timer_interval);
-			gui_refresh_timer_.elapse([this](const nana::arg_elapse&) {
-				if (this->textbox_.edited())
-					this->_post_textbox_edited(true);
-				if (this->textbox_.focused())
-					this->refresh_textbox_line_num();
+			// register to the frame scheduler instead of polling the textbox with an own timer
+			frame_task_id_ = parent_tab_page.frame_scheduler().add_task(parent_tab_page, [this] {
+				return this->_service_frame();
 			});
-			gui_refresh_timer_.start();
+		}
+
+		AbstractBoxUnit::~AbstractBoxUnit()
+		{
+			tab_page_ptr_->frame_scheduler().remove_task(frame_task_id_);
+		}
+
+		void AbstractBoxUnit::mark_dirty() noexcept
+		{
+			is_marked_dirty_ = true;
+			tab_page_ptr_->frame_scheduler().mark_dirty(frame_task_id_);
 		}
 
 		void AbstractBoxUnit::_make_textbox_line_num() noexcept
@@ -55,8 +57,14 @@ namespace text_overseer
 				if (text_pos.empty())
 					return;
 
-				auto largest_num = text_pos.back().y + 1;
-				unsigned int log10_num = static_cast<int>(std::log10(largest_num));
+				// the width grows by the digit count of the largest line number
+				auto largest_num = static_cast<std::uint64_t>(text_pos.back().y) + 1;
+				unsigned int log10_num = 0;
+				while (largest_num >= 10)
+				{
+					largest_num /= 10;
+					log10_num++;
+				}
 				const unsigned int width = log10_num * 8 + 15;
 
 				// check whether the current width is suitable or not
@@ -78,7 +86,7 @@ namespace text_overseer
 				// draw the line numbers
 				for (const auto& pos : text_pos)
 				{
-					const auto num_wstr = std::to_wstring(pos.y + 1);
+					const auto num_wstr = std::to_wstring(static_cast<std::uint64_t>(pos.y) + 1);
 					const auto pixels = graph.text_extent_size(num_wstr).width;
 					graph.rectangle({ 2, top, inner_width, line_height }, true, this->_line_num_color(pos.y));
 					graph.string({ static_cast<int>(inner_width - pixels), top }, num_wstr);
@@ -89,11 +97,93 @@ namespace text_overseer
 			// nana::drawerbase::textbox::textbox_events event doesn't work at all (nana 1.4.1)
 
 			textbox_.events().mouse_wheel([this] {
-				this->refresh_textbox_line_num();
+				this->mark_dirty();
 			}); // mouse wheel does effect(changes its line position) even when it's not focused
 
 			textbox_.events().resized([this] {
-				this->refresh_textbox_line_num();
+				this->mark_dirty();
+			});
+		}
+
+		void AbstractBoxUnit::_set_state_caption(const char* first, const char* last)
+		{
+			const auto len = static_cast<std::size_t>(last - first);
+			if (lab_state_text_.size() == len && std::equal(first, last, lab_state_text_.begin()))
+				return;
+			lab_state_text_.assign(first, last);
+			lab_state_.caption(lab_state_text_);
+		}
+
+		bool AbstractBoxUnit::_service_frame() noexcept
+		{
+			if (textbox_.edited())
+				_post_textbox_edited(true);
+
+			// while it only follows the scrollbar, the line numbers are drawn again only if the text scrolled
+			std::size_t first_line = 0;
+			try
+			{
+				first_line = _textbox_first_line();
+			}
+			catch (std::exception&)
+			{
+				is_marked_dirty_ = true;
+			}
+			if (!is_following_scroll_ || is_marked_dirty_ || first_line != drawn_first_line_)
+			{
+				refresh_textbox_line_num();
+				drawn_first_line_ = first_line;
+			}
+			is_marked_dirty_ = false;
+
+			// dragging the scrollbar of the textbox sends the mouse events to the scrollbar, not to the textbox,
+			// so the first line is checked on every frame while the cursor is on the textbox
+			is_following_scroll_ = _is_cursor_on_textbox();
+			return is_following_scroll_;
+		}
+
+		bool AbstractBoxUnit::_is_cursor_on_textbox() const noexcept
+		{
+			auto pos = API::cursor_position();
+			API::calc_window_point(textbox_, pos);
+			const auto size = textbox_.size();
+			return pos.x >= 0 && pos.y >= 0
+				&& static_cast<unsigned int>(pos.x) < size.width && static_cast<unsigned int>(pos.y) < size.height;
+		}
+
+		std::size_t AbstractBoxUnit::_textbox_first_line() const
+		{
+			const auto text_pos = textbox_.text_position(); // only the lines in view
+			return text_pos.empty() ? 0 : text_pos.front().y;
+		}
+
+		void AbstractBoxUnit::_make_textbox_dirty_events() noexcept
+		{
+			// the textbox is checked on the next frame, after it has handled the input itself
+			textbox_.events().key_press([this] {
+				this->mark_dirty();
+			});
+
+			textbox_.events().key_char([this] {
+				this->mark_dirty();
+			});
+
+			textbox_.events().mouse_up([this] {
+				this->mark_dirty();
+			});
+
+			textbox_.events().mouse_move([this](const arg_mouse& arg) {
+				if (arg.left_button) // selecting by dragging can scroll the text
+					this->mark_dirty();
+			});
+
+			textbox_.events().focus([this] {
+				this->mark_dirty();
+			});
+
+			// the frames follow the scrollbar of the textbox from here on, until the cursor leaves the textbox
+			textbox_.events().mouse_enter([this] {
+				this->mark_dirty();
 			});
 		}
 
@@ -107,6 +197,7 @@ namespace text_overseer
 
 			popup_menu_.append(u8"붙여넣기 (Ctrl+V)", [this](menu::item_proxy& ip) {
 				this->textbox_.paste();
+				this->mark_dirty();
 			});
 
 			popup_menu_.append_splitter();
@@ -122,56 +213,12 @@ namespace text_overseer
 			});
 		}
 
-		AnswerTextBoxUnit::AnswerTextBoxUnit(IOFilesTabPage& parent_tab_page)
-			: AbstractBoxUnit(parent_tab_page)
-		{
-			place_.div(
-				"<vert "
-				"  <weight=25 margin=[0,0,3,0] lab_name>"
-				"  <"
-				"    <weight=15 line_num>"
-				"    <weight=2>"
-				"    <textbox>"
-				"  >"
-				"  <weight=42 margin=[3,0,0,0] lab_state>"
-				">"
-			);
-			place_["lab_name"] << lab_name_;
-			place_["line_num"] << line_num_;
-			place_["textbox"] << textbox_;
-			place_["lab_state"] << lab_state_;
-
-			lab_name_.caption(u8"<size=11>정답 출력</>");
-			lab_state_.format(true);
-
-			_make_textbox_line_num();
-		}
-
-		color AnswerTextBoxUnit::_line_num_color(unsigned int num) noexcept
-		{
-			if (file_line_count_if_shorter_ != 0 && num >= file_line_count_if_shorter_)
-				return colors::orange_red;
-			return k_line_num_default_color;
-		}
-
-		void AnswerTextBoxUnit::_post_textbox_edited(bool is_edited) noexcept
-		{
-			if (is_edited)
-			{
-				tab_page_ptr_->output_box_line_diff();
-				_reset_textbox_edited();
-			}
-		}
-
 		AbstractIOFileBoxUnit::AbstractIOFileBoxUnit(IOFilesTabPage& parent_tab_page)
 			: AbstractBoxUnit(parent_tab_page)
 		{
 			// combo box order relys on FileIO::encoding
-			combo_locale_.push_back(u8"자동");
-			combo_locale_.push_back("ANSI");
-			combo_locale_.push_back("UTF-8");
-			combo_locale_.push_back(u8"서명 없는 UTF-8");
-			combo_locale_.push_back("UTF-16LE");
+			for (const auto name : k_encoding_names)
+				combo_locale_.push_back(name);
 
 			// widgets
 			btn_reload_.enabled(false);
@@ -182,50 +229,61 @@ namespace text_overseer
 
 		bool AbstractIOFileBoxUnit::update_label_state() noexcept
 		{
-			const auto file_is_changed = _check_last_write_time();
+			return update_label_state(_stat_file());
+		}
+
+		bool AbstractIOFileBoxUnit::update_label_state(const file_system::FileStatResult& stat) noexcept
+		{
+			const auto file_is_changed = _check_last_write_time(stat);
 
 			if (file_is_changed)
 			{
 				bool did_read_file = false;
 
-				for (auto i = 0; i < k_max_count_read_file; i++)
+				// a load never waits for the GUI, so it isn't retried; a failure is reported by show_loaded_file()
+				try
 				{
-					try
-					{
-						// read the file
-						did_read_file = read_file();
-					}
-					catch (std::exception& e)
-					{
-						ErrorHdr::instance().report(
-							ErrorHdr::priority::critical, 0,
-							std::string("Unknown error in the file read function - ") + e.what(),
-							wstr_to_utf8(file_.filename())
-						);
-					}
-					if (did_read_file)
-						break;
+					// show the file if it was loaded in a batch, or read it
+					did_read_file = has_loaded_file() ? show_loaded_file() : read_file();
+				}
+				catch (std::exception& e)
+				{
+					ErrorHdr::instance().report(
+						ErrorHdr::priority::critical, 0,
+						std::string("Unknown error in the file read function - ") + e.what(),
+						wstr_to_utf8(file_.filename())
+					);
 				}
 
 				if (!did_read_file)
 				{
-					lab_state_.caption(u8"파일을 열지 못했습니다.");
+					_set_state_caption(u8"파일을 열지 못했습니다.");
 					return false;
 				}
 			}
 			else if (!last_write_time_is_vaild_)
 			{
-				lab_state_.caption(u8"파일을 찾지 못했습니다.");
+				_set_state_caption(u8"파일을 찾지 못했습니다.");
 				return false;
 			}
 
-			const auto term = std::chrono::system_clock::now() - last_write_time_;
-			auto str = file_system::time_duration_to_string(
+			// the text only changes once a second, so the label is seldom set
+			// a guessed encoding is marked, so that the user checks the combo box if the text looks broken
+			const char k_ago[] = u8"전";
+			const char k_guessed[] = u8" (인코딩 추정)";
+			char buf[file_system::k_time_duration_buffer_size + sizeof(k_ago) + sizeof(k_guessed)];
+			const auto term = std::chrono::system_clock::now() - stamp_.last_write_time();
+			auto buf_end = file_system::write_time_duration(
+				std::begin(buf),
+				std::end(buf) - sizeof(k_ago) - sizeof(k_guessed),
 				std::chrono::duration_cast<std::chrono::seconds>(term),
 				false,
 				file_system::time_period_strings::k_korean_u8
-			) + u8"전";
-			lab_state_.caption(std::move(str));
+			);
+			buf_end = std::copy(std::begin(k_ago), std::end(k_ago) - 1, buf_end);
+			if (is_file_locale_guessed_)
+				buf_end = std::copy(std::begin(k_guessed), std::end(k_guessed) - 1, buf_end);
+			_set_state_caption(buf, buf_end);
 
 			refresh_textbox_line_num();
 
@@ -234,48 +292,139 @@ namespace text_overseer
 
 		bool AbstractIOFileBoxUnit::read_file()
 		{
-			std::unique_lock<std::mutex> lock(file_mutex_, std::try_to_lock);
-
-			if (!lock)
-				return false; // return if the file process is busy (fail trying to lock)
+			load_file();
+			return show_loaded_file();
+		}
 
-			if (!file_.open(std::ios::in | std::ios::binary))
+		bool AbstractIOFileBoxUnit::load_file() noexcept
+		{
+			// the buffers of the file shown last are reused, so a reload of a similar size doesn't allocate
+			auto loaded = std::atomic_exchange(&spare_loaded_file_, std::shared_ptr<LoadedFile>());
+			try
+			{
+				if (!loaded)
+					loaded = std::make_shared<LoadedFile>();
+			}
+			catch (std::exception&)
 			{
-				ErrorHdr::instance().report(
-					ErrorHdr::priority::info, 0, "Cannot open the file to read", wstr_to_utf8(file_.filename())
-				);
 				return false;
 			}
 
-			FileIOClosingGuard file_closer(file_);
-			std::string str;
-
+			loaded->error.clear();
 			try
 			{
-				str = file_.read_all();
+				FileIO file(file_.filename_wstring(), load_locale_);
+				if (!file.open(std::ios::in | std::ios::binary))
+					throw std::runtime_error("cannot open the file to read");
+
+				FileIOClosingGuard file_closer(file);
+				auto& buffers = loaded->buffers;
+
+				const auto time_start = std::chrono::high_resolution_clock::now();
+
+				// the reader is chosen once by the BOM (or by detection), and the textbox takes any newline
+				loaded->locale = read_text(file, buffers.bytes, WideSink(buffers.wide), newline_style::preserve);
+				if (loaded->locale == FileIO::encoding::unknown)
+					throw std::runtime_error("cannot read the file");
+				loaded->newline = detect_newline_style(buffers.wide.data(), buffers.wide.data() + buffers.wide.size());
+				loaded->detection_confidence = file.detection_confidence();
+				_post_load_file(*loaded);
+
+				loaded->load_duration = std::chrono::high_resolution_clock::now() - time_start;
 			}
 			catch (std::exception& e)
+			{
+				loaded->error = std::string("Error while reading the file - ") + e.what();
+			}
+
+			const auto is_loaded = loaded->error.empty();
+
+			// publish it; the one not shown yet is older, so it's just reused
+			auto superseded = std::atomic_exchange(&loaded_file_, std::move(loaded));
+			if (superseded)
+			{
+				superseded->trim(k_max_kept_buffer_size);
+				std::atomic_store(&spare_loaded_file_, std::move(superseded));
+			}
+			return is_loaded;
+		}
+
+		bool AbstractIOFileBoxUnit::show_loaded_file()
+		{
+			auto loaded = std::atomic_exchange(&loaded_file_, std::shared_ptr<LoadedFile>());
+			if (!loaded)
+				return false; // nothing is loaded since it was shown last
+
+			auto is_shown = false;
+			if (!loaded->error.empty())
 			{
 				ErrorHdr::instance().report(
-					ErrorHdr::priority::info, 0,
-					std::string("Error while reading the file - ") + e.what(),
-					wstr_to_utf8(file_.filename())
+					ErrorHdr::priority::info, 0, loaded->error, wstr_to_utf8(file_.filename())
 				);
-				return false;
 			}
+			else
+			{
+				textbox_.caption(loaded->buffers.wide);
+				shown_text_size_ = loaded->buffers.wide.size() * sizeof(wchar_t);
 
-			const auto locale = file_.locale();
+				_report_bandwidth("Read", loaded->buffers.bytes.size(), loaded->load_duration);
 
-			if (locale == FileIO::encoding::system) // ANSI
-				textbox_.caption(charset(std::move(str)).to_bytes(unicode::utf8));
-			else if (locale == FileIO::encoding::utf16_le) // UTF-16LE
-				textbox_.caption(charset(std::move(str), unicode::utf16).to_bytes(unicode::utf8));
-			else // UTF-8
-				textbox_.caption(std::move(str));
+				_reset_textbox_edited();
+				_set_file_locale(loaded->locale);
+				_show_file_locale(loaded->locale);
+				file_.newline(loaded->newline);
+				is_file_locale_guessed_ = loaded->detection_confidence < k_min_sure_detection_confidence;
+				_post_show_file(*loaded);
+				is_shown = true;
+			}
 
-			_reset_textbox_edited();
-			combo_locale_.option(static_cast<std::size_t>(locale)); // event won't happen because of mutex lock
-			return true;
+			// the textbox has its own copy now, and the shared contents are held by the box units;
+			// the buffers are kept to be reused by the next load
+			loaded->trim(k_max_kept_buffer_size);
+			std::atomic_store(&spare_loaded_file_, std::move(loaded));
+			return is_shown;
+		}
+
+		void AbstractIOFileBoxUnit::_show_file_locale(FileIO::encoding locale)
+		{
+			is_showing_file_locale_ = true; // the selected event is raised in option()
+			combo_locale_.option(static_cast<std::size_t>(locale));
+			is_showing_file_locale_ = false;
+		}
+
+		void AbstractIOFileBoxUnit::_report_bandwidth(
+			const char*									job_name,
+			std::size_t									byte_size,
+			std::chrono::high_resolution_clock::duration	duration
+		) noexcept
+		{
+			if (!ErrorHdr::instance().is_started())
+				return;
+			try
+			{
+				const auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+				std::ostringstream oss;
+				oss << job_name << " " << byte_size << " bytes in " << usecs << " us";
+				if (usecs > 0)
+					oss << " (" << static_cast<double>(byte_size) / usecs << " MB/s)";
+				ErrorHdr::instance().report(ErrorHdr::priority::info, 0, oss.str(), wstr_to_utf8(file_.filename()));
+			}
+			catch (std::exception&)
+			{
+				// do nothing
+			}
+		}
+
+		void AbstractIOFileBoxUnit::add_memory_usage(MemoryUsage& usage) const noexcept
+		{
+			usage.widget_text += shown_text_size_;
+			usage.buffers += io_buffers_.memory_size();
+			if (const auto spare = std::atomic_load(&spare_loaded_file_)) // no load is running on the GUI thread
+			{
+				usage.buffers += spare->buffers.memory_size();
+				if (spare->text)
+					usage.buffers += spare->text->capacity();
+			}
 		}
 
 		bool AbstractIOFileBoxUnit::is_same_file(const std::wstring& path_str) const noexcept
@@ -287,25 +436,52 @@ namespace text_overseer
 			return own_path.compare(param_path) == 0;
 		}
 
-		bool AbstractIOFileBoxUnit::_check_last_write_time() noexcept
+		bool AbstractIOFileBoxUnit::is_file_changed(const file_system::FileStatResult& stat) const noexcept
 		{
-			if (file_.filename_wstring().empty())
+			if (file_.filename_wstring().empty() || stat.ec)
 				return false;
+			// any difference counts, not only a newer write time; e.g. a file replaced by an older one
+			if (!last_write_time_is_vaild_)
+				return stat.stamp.is_known();
+			return stat.stamp.is_known() && stat.stamp != stamp_;
+		}
 
-			boost::system::error_code ec;
-			file_system::TimePointOfSys time_gotton;
+		file_system::FileStatResult AbstractIOFileBoxUnit::shown_stat() const noexcept
+		{
+			file_system::FileStatResult stat;
+			if (last_write_time_is_vaild_)
+				stat.stamp = stamp_;
+			return stat;
+		}
+
+		file_system::FileStatResult AbstractIOFileBoxUnit::_stat_file() const noexcept
+		{
+			file_system::FileStatResult stat;
+
+			if (file_.filename_wstring().empty())
+				return stat;
 
 			for (auto i = 0; i < k_max_count_check_last_file_write; i++)
 			{
-				time_gotton = file_system::file_last_write_time(file_.filename(), ec);
-				if (!ec)
+				stat = file_system::stat_file(file_.filename_wstring());
+				if (!stat.ec)
 					break;
 			}
+			return stat;
+		}
 
-			if (last_write_time_ < time_gotton
-				|| (!last_write_time_is_vaild_ && time_gotton.time_since_epoch().count() != 0LL))
+		bool AbstractIOFileBoxUnit::_check_last_write_time(const file_system::FileStatResult& stat) noexcept
+		{
+			if (file_.filename_wstring().empty())
+				return false;
+
+			// a batched stat is tried once; retry it here
+			const auto checked = stat.ec ? _stat_file() : stat;
+			const auto& ec = checked.ec;
+
+			if (is_file_changed(checked))
 			{
-				last_write_time_ = time_gotton;
+				stamp_ = checked.stamp;
 				last_write_time_is_vaild_ = true;
 				btn_reload_.enabled(true);
 				return true;
@@ -342,18 +518,12 @@ namespace text_overseer
 			});
 
 			combo_locale_.events().selected([this](const arg_combox& arg_combo) {
+				if (this->is_showing_file_locale_)
+					return; // it's not chosen by the user
 				// update file locale
-				for (auto i = 0; i < k_max_count_try_to_update_widget; i++)
-				{
-					std::unique_lock<std::mutex> lock(this->file_mutex_, std::try_to_lock); // to avoid deadlock
-					if (lock)
-					{
-						file_.locale(static_cast<FileIO::encoding>(arg_combo.widget.option()));
-						lock.unlock(); // InputFileBoxUnit::_post_textbox_edited() uses the mutex lock too
-						this->_post_textbox_edited(true);
-						break;
-					}
-				}
+				this->is_file_locale_guessed_ = false;
+				this->_set_file_locale(static_cast<FileIO::encoding>(arg_combo.widget.option()));
+				this->_post_textbox_edited(true);
 			});
 		}
 
@@ -413,32 +583,8 @@ namespace text_overseer
 			_make_textbox_line_num();
 		}
 
-		bool InputFileBoxUnit::read_file()
-		{
-			if (!AbstractIOFileBoxUnit::read_file()) // call its parent class's method
-				return false;
-
-			text_backup_u8_ = textbox_.caption();
-
-			// in texts from nana the newline escapes are used as \n\r(LF CR)
-			// => which causes a broken text file view in Windows; \r\n(CR LF) is normal
-			std::size_t pos = 0;
-			while ((pos = text_backup_u8_.find("\n\r", pos + 1)) != std::string::npos)
-			{
-				text_backup_u8_[pos] = L'\r';
-				text_backup_u8_[++pos] = L'\n';
-			}
-
-			return true;
-		}
-
 		void InputFileBoxUnit::_post_textbox_edited(bool is_edited) noexcept
 		{
-			std::unique_lock<std::mutex> lock(file_mutex_, std::try_to_lock);
-
-			if (!lock)
-				return; // return if the file process is busy (fail trying to lock)
-
 			if (!did_post_edited_ && is_edited)
 			{
 				btn_save_.bgcolor(colors::orange);
@@ -449,7 +595,7 @@ namespace text_overseer
 
 		void InputFileBoxUnit::_reset_textbox_edited() noexcept
 		{
-			// this function doesn't need mutex lock because it will be called from the read & write function
+			// it's called from the read & write functions on the GUI thread
 			AbstractIOFileBoxUnit::_reset_textbox_edited();
 			btn_save_.bgcolor(colors::button_face);
 			auto str = lab_name_.caption();
@@ -464,95 +610,89 @@ namespace text_overseer
 
 		bool InputFileBoxUnit::_write_file()
 		{
-			std::unique_lock<std::mutex> lock(file_mutex_, std::try_to_lock);
-
-			if (!lock)
-				return false; // return if the file process is busy (fail trying to lock)
-
-			if (!file_.open(std::ios::out | std::ios::binary))
-			{
-				ErrorHdr::instance().report(
-					ErrorHdr::priority::critical, 0, "Cannot open the file to write", wstr_to_utf8(file_.filename())
-				);
-				msgbox mb(*this, u8"파일 쓰기 실패 (파일 열기)");
-				mb.icon(msgbox::icon_error) << u8"파일 쓰기 도중 파일 열기에 실패했습니다.";
-				mb.show();
-				return false;
-			}
-
-			FileIOClosingGuard file_closer(file_);
-
-			std::string buf;
+			// the whole text is converted before touching the file;
+			// the file is replaced at once by FileIO::write_all_atomic() and never exposed partially written
 			auto locale = file_.locale();
+			const auto caption = textbox_.caption_wstring();
+			const auto time_start = std::chrono::high_resolution_clock::now();
+
+			// convert into the reused buffers; the newlines are normalized in the same pass
+			// (in texts from nana the newline escapes are used as \n\r(LF CR), which is not a normal newline)
+			auto& buf = io_buffers_.bytes;
+			auto& u16_buf = io_buffers_.u16;
+			auto& u32_buf = io_buffers_.u32;
+			const char* data = nullptr; // the bytes to be written
+			std::size_t byte_size = 0;
 
 			if (locale == FileIO::encoding::unknown || locale == FileIO::encoding::system)
 			{
-				auto caption = textbox_.caption_wstring();
 				try
 				{
-					buf = wstr_to_mstr(caption);
+					transcode(WideSource(caption), SystemSink(buf), file_.newline());
+					data = buf.data();
+					byte_size = buf.size();
 				}
 				catch (std::range_error& e) // conversion fail on account of some unicode character
 				{
 					// substitute "\\n" for newline characters in caption string
+					auto caption_escaped = caption;
 					std::size_t pos = 0;
-					while ((pos = caption.find(L"\n\r", pos + 1)) != std::string::npos)
+					while ((pos = caption_escaped.find(L"\n\r", pos + 1)) != std::wstring::npos)
 					{
-						caption[pos] = L'\\';
-						caption[++pos] = L'n';
+						caption_escaped[pos] = L'\\';
+						caption_escaped[++pos] = L'n';
 					}
 
 					// report character conversion error
 					ErrorHdr::instance().report(
 						ErrorHdr::priority::critical, 0,
 						std::string("Encoding conversion failed when writing the file (UTF-8 to ANSI) - ") + e.what(),
-						wstr_to_utf8(caption)
+						wstr_to_utf8(caption_escaped)
 					);
 
-					// restore the file from backup
-					_restore_opened_file_to_utf8();
-
-					combo_locale_.option(static_cast<std::size_t>(FileIO::encoding::utf8));
-
-					file_closer.close_safe(); // manual file close before unlock
-					lock.unlock(); // manual unlock before nana::combox::option()
+					// the file is untouched; the next save will be in UTF-8
+					io_buffers_.trim(k_max_kept_buffer_size);
+					_set_file_locale(FileIO::encoding::utf8);
+					_show_file_locale(FileIO::encoding::utf8);
 
 					// open a message box
 					msgbox mb(*this, u8"파일 쓰기 실패 (인코딩 오류)");
 					mb.icon(msgbox::icon_error);
 					mb << u8"파일 쓰기 도중 변환할 수 없는 유니코드 문자가 발견되었습니다.\n";
-					mb << u8"오류에 따른 파일 복구를 시도했습니다. (UTF-8)";
+					mb << u8"파일은 변경되지 않았습니다. 인코딩을 UTF-8로 바꿨으니 다시 저장해 주세요.";
 					mb.show();
 
 					return false;
 				}
 			}
-			else // UTF-8 or UTF-16LE
+			else if (FileIO::code_unit_size(locale) == 2) // UTF-16LE, UTF-16BE
 			{
-				buf = textbox_.caption();
+				transcode(WideSource(caption), Utf16Sink(u16_buf), file_.newline());
+				if (FileIO::is_big_endian(locale))
+					swap_byte_order_16(&u16_buf[0], u16_buf.size());
+				data = reinterpret_cast<const char*>(u16_buf.data());
+				byte_size = u16_buf.size() * 2;
 			}
-
-			// in texts from nana the newline escapes are used as \n\r(LF CR)
-			// => which causes a broken text file view in Windows; \r\n(CR LF) is normal
-			std::size_t pos = 0;
-			while ((pos = buf.find("\n\r", pos + 1)) != std::string::npos)
+			else if (FileIO::code_unit_size(locale) == 4) // UTF-32LE, UTF-32BE
 			{
-				buf[pos] = '\r';
-				buf[++pos] = '\n';
+				transcode(WideSource(caption), Utf32Sink(u32_buf), file_.newline());
+				if (FileIO::is_big_endian(locale))
+					swap_byte_order_32(&u32_buf[0], u32_buf.size());
+				data = reinterpret_cast<const char*>(u32_buf.data());
+				byte_size = u32_buf.size() * 4;
+			}
+			else // UTF-8
+			{
+				transcode(WideSource(caption), Utf8Sink(buf), file_.newline());
+				data = buf.data();
+				byte_size = buf.size();
 			}
 
-			std::u16string u16_buf;
-
-			// charset(u8_str, unicode::utf8).to_bytes(unicode::utf16) is not good; better use std::wstring_convert
-			if (locale == FileIO::encoding::utf16_le) // UTF-16LE
-				u16_buf = utf8_to_utf16(buf);
-
+			auto is_written = true;
 			try
 			{
-				if (locale == FileIO::encoding::utf16_le)
-					file_.write_all(u16_buf.data(), u16_buf.size() * 2);
-				else
-					file_.write_all(buf.data(), buf.size());
+				if (!file_.write_all_atomic(data, byte_size, k_do_sync_when_saving))
+					throw std::runtime_error("the file is busy or has no name");
 			}
 			catch (std::exception& e)
 			{
@@ -561,45 +701,29 @@ namespace text_overseer
 					ErrorHdr::priority::critical, 0,
 					std::string("Error while writing the file - ") + e.what(), wstr_to_utf8(file_.filename())
 				);
+				is_written = false;
+			}
+			io_buffers_.trim(k_max_kept_buffer_size); // the textbox has the text
 
-				// restore the file from backup
-				_restore_opened_file_to_utf8();
-
-				combo_locale_.option(static_cast<std::size_t>(FileIO::encoding::utf8));
-
-				file_closer.close_safe(); // manual file close before unlock
-				lock.unlock(); // manual unlock before nana::combox::option()
-
+			if (!is_written)
+			{
 				// open a message box
 				msgbox mb(*this, u8"파일 쓰기 실패");
 				mb.icon(msgbox::icon_error);
 				mb << u8"파일 쓰기 도중 직접적인 오류가 발생했습니다.\n";
-				mb << u8"오류에 따른 파일 복구를 시도했습니다. (UTF-8)";
+				mb << u8"파일은 변경되지 않았습니다.";
 				mb.show();
 
 				return false;
 			}
 
+			_report_bandwidth("Wrote", byte_size, std::chrono::high_resolution_clock::now() - time_start);
+
 			_reset_textbox_edited();
-			combo_locale_.option(static_cast<std::size_t>(locale)); // its event won't happen because of the mutex lock
+			_show_file_locale(locale);
 			return true;
 		}
 
-		void InputFileBoxUnit::_restore_opened_file_to_utf8()
-		{
-			if (!file_.is_open() || text_backup_u8_.empty())
-				return;
-			file_.locale(FileIO::encoding::utf8);
-			try
-			{
-				file_.write_all(text_backup_u8_.data(), text_backup_u8_.size());
-			}
-			catch (std::exception&)
-			{
-				// do nothing
-			}
-		}
-
 		OutputFileBoxUnit::OutputFileBoxUnit(IOFilesTabPage& parent_tab_page)
 			: AbstractIOFileBoxUnit(parent_tab_page)
 		{
@@ -649,148 +773,183 @@ namespace text_overseer
 			_make_textbox_line_num();
 		}
 
-		bool OutputFileBoxUnit::read_file()
+		bool OutputFileBoxUnit::show_loaded_file()
 		{
-			if (!AbstractIOFileBoxUnit::read_file()) // call its parent class's method
+			if (!AbstractIOFileBoxUnit::show_loaded_file()) // call its parent class's method
 				return false;
 
 			tab_page_ptr_->output_box_line_diff();
 			return true;
 		}
 
-		int OutputFileBoxUnit::line_diff_between_answer(const std::string& answer)
+		line_diff::LineDiffResult OutputFileBoxUnit::line_diff_between_answer(const line_diff::AnswerIndex& answer)
 		{
-			// clear the result
-			did_line_diff_ = false;
-			line_diff_results_.clear();
-
-			// nana::widget::caption returns string that newlined as "\n\r"
-			const auto file_str = textbox_.caption();
+			// the text loaded is compared, not a copy of the textbox caption; the textbox isn't editable
+			const char* first = nullptr;
+			const char* last = nullptr;
+			if (shown_text_)
+			{
+				first = shown_text_->data();
+				last = first + shown_text_->size();
+			}
 
-			if (file_str.empty() || answer.empty())
-				return static_cast<int>(line_diff_sign::error);
+			const auto result = line_diff::diff_lines(first, last, answer, line_diff_results_);
+			did_line_diff_ = result.status != line_diff::diff_status::error;
+			return result;
+		}
 
-			// using typename CIterRange
-			using CIterRange = boost::iterator_range<std::string::const_iterator>;
+		color OutputFileBoxUnit::_line_num_color(std::uint64_t num) noexcept
+		{
+			if (!did_line_diff_ || num >= line_diff_results_.size())
+				return k_line_num_default_color;
+			if (line_diff_results_[num])
+				return colors::yellow_green;
+			return colors::orange_red;
+		}
 
-			// token iter split for lines
-			std::vector<CIterRange> f_lines, a_lines;
-			boost::iter_split(f_lines, file_str, boost::token_finder(boost::is_any_of("\n")));
-			boost::iter_split(a_lines, answer, boost::token_finder(boost::is_any_of("\n")));
+		void OutputFileBoxUnit::add_memory_usage(MemoryUsage& usage) const noexcept
+		{
+			AbstractIOFileBoxUnit::add_memory_usage(usage);
+			if (shown_text_)
+				usage.shared_text += shown_text_->capacity() / static_cast<std::size_t>(shown_text_.use_count());
+			usage.line_diff += line_diff_results_.memory_size();
+		}
 
-			const auto f_lines_size = f_lines.size();
-			const auto a_lines_size = a_lines.size();
-			std::size_t i, j;
+		void OutputFileBoxUnit::_post_load_file(LoadedFile& loaded)
+		{
+			// the spare load has the text shown before the current one, which nothing else holds
+			if (!loaded.text)
+				loaded.text = std::make_shared<std::string>();
+			loaded.text->reserve(loaded.buffers.wide.size());
+			transcode(WideSource(loaded.buffers.wide), Utf8Sink(*loaded.text), newline_style::preserve);
+		}
 
-			// loop for lines
-			for (i = 0, j = 0; i < f_lines_size && j < a_lines_size; i++, j++)
-			{
-				// ignore empty lines
-				if (f_lines[i].begin() == f_lines[i].end())
-				{
-					if (a_lines[j].begin() != a_lines[j].end()) // prevent an infinite loop
-						j--;
-					continue;
-				}
-				if (a_lines[j].begin() == a_lines[j].end())
-				{
-					i--;
-					continue;
-				}
+		void OutputFileBoxUnit::_post_show_file(LoadedFile& loaded)
+		{
+			std::swap(shown_text_, loaded.text); // the former text goes to the spare load, to be reused
+		}
 
-				// token iter split for words
-				std::vector<CIterRange> f_words, a_words;
-				boost::iter_split(f_words, f_lines[i], boost::token_finder(boost::is_any_of(" \t\r")));
-				boost::iter_split(a_words, a_lines[i], boost::token_finder(boost::is_any_of(" \t\r")));
+		AnswerFileBoxUnit::AnswerFileBoxUnit(IOFilesTabPage& parent_tab_page)
+			: AbstractIOFileBoxUnit(parent_tab_page)
+		{
+			// div
+			place_.div(
+				"<vert "
+				"  <weight=25 margin=[0,0,3,0]"
+				"    <lab_name>"
+				"    <weight=70 btn_reload>"
+				"  >"
+				"  <"
+				"    <weight=15 line_num>"
+				"    <weight=2>"
+				"    <textbox>"
+				"  >"
+				"  <weight=42 margin=[3,0,0,0]"
+				"    <vert"
+				"      <margin=[0,0,3,0] lab_state>"
+				"      < <> <weight=110 combo_locale> >"
+				"    >"
+				"  >"
+				"  <weight=42 margin=[3,0,0,0] lab_diff>"
+				">"
+			);
+			place_["lab_name"] << lab_name_;
+			place_["btn_reload"] << btn_reload_;
+			place_["line_num"] << line_num_;
+			place_["textbox"] << textbox_;
+			place_["lab_state"] << lab_state_;
+			place_["combo_locale"] << combo_locale_;
+			place_["lab_diff"] << lab_diff_;
 
-				const auto f_words_size = f_words.size();
-				const auto a_words_size = a_words.size();
-				std::size_t k, l;
+			// widget initiation - label
+			lab_name_.caption(u8"<size=11>정답 출력</>");
+			lab_state_.format(true);
+			lab_diff_.format(true);
 
-				auto line_is_different = false;
+			// widget initiation - combox
+			combo_locale_.enabled(false);
 
-				// loop for words
-				for (k = 0, l = 0; k < f_words_size && l < a_words_size; k++, l++)
-				{
-					// check the sizes to prevent an exception when building boost::string_view objects
-					if (f_words[k].size() == 0)
-					{
-						if (a_words[l].size() != 0) // prevent an infinite loop
-							l--;
-						continue;
-					}
-					if (a_words[l].size() == 0)
-					{
-						k--;
-						continue;
-					}
+			_make_textbox_line_num();
+		}
 
-					boost::string_view f_sv(&*f_words[k].begin(), f_words[k].size());
-					boost::string_view a_sv(&*a_words[l].begin(), a_words[l].size());
+		bool AnswerFileBoxUnit::show_loaded_file()
+		{
+			if (!AbstractIOFileBoxUnit::show_loaded_file()) // call its parent class's method
+				return false;
 
-					// comparison of two boost::string_view objects
-					if (f_sv != a_sv)
-					{
-						line_is_different = true;
-						break;
-					}
-				}
+			is_typed_ = false;
+			tab_page_ptr_->output_box_line_diff();
+			return true;
+		}
 
-				// check if there are remaining words not compared together
-				if (!line_is_different && k != f_words_size)
-				{
-					while (k < f_words_size)
-					{
-						if (f_words[k++].size() != 0)
-						{
-							line_is_different = true;
-							break;
-						}
-					}
-				}
-				else if (!line_is_different && l != a_words_size)
-				{
-					while (l < a_words_size)
-					{
-						if (a_words[l++].size() != 0)
-						{
-							line_is_different = true;
-							break;
-						}
-					}
-				}
+		const line_diff::AnswerIndex& AnswerFileBoxUnit::answer_index()
+		{
+			if (shared_answer_)
+				return shared_answer_->index;
+			if (!answer_index_is_valid_)
+			{
+				typed_answer_ = textbox_.caption();
+				answer_index_.build(typed_answer_.data(), typed_answer_.data() + typed_answer_.size());
+				answer_index_is_valid_ = true;
+			}
+			return answer_index_;
+		}
 
-				// push the result to line_diff_results_
-				if (line_is_different)
-					line_diff_results_.push_back(false);
-				else
-					line_diff_results_.push_back(true);
+		void AnswerFileBoxUnit::add_memory_usage(MemoryUsage& usage) const noexcept
+		{
+			AbstractIOFileBoxUnit::add_memory_usage(usage);
+			if (shared_answer_)
+			{
+				// the pages whose answer files are the same share it
+				const auto holders = static_cast<std::size_t>(shared_answer_.use_count());
+				usage.shared_text += shared_answer_->text.capacity() / holders;
+				usage.line_diff += shared_answer_->index.memory_size() / holders;
 			}
+			usage.shared_text += typed_answer_.capacity();
+			usage.line_diff += answer_index_.memory_size();
+		}
 
-			// calculate the remaining lines in the file
-			auto f_rest_lines_size = f_lines_size - i;
-			// exception for a newline at the end of the file
-			if (f_rest_lines_size && boost::ends_with(file_str, "\n\r"))
-				f_rest_lines_size--;
-			// push failed results for the remaining lines in the file
-			for (i = 0; i < f_rest_lines_size; i++)
-				line_diff_results_.push_back(false);
+		void AnswerFileBoxUnit::label_no_file()
+		{
+			_set_state_caption(u8"정답 파일이 없습니다. 위에 직접 입력하세요.");
+		}
 
-			did_line_diff_ = true;
+		color AnswerFileBoxUnit::_line_num_color(std::uint64_t num) noexcept
+		{
+			if (file_line_count_if_shorter_ != 0 && num >= file_line_count_if_shorter_)
+				return colors::orange_red;
+			return k_line_num_default_color;
+		}
 
-			if (f_lines_size < a_lines_size)
-				return f_lines_size;
+		void AnswerFileBoxUnit::_post_load_file(LoadedFile& loaded)
+		{
+			// the textbox takes the wide text, and the cache takes it in UTF-8
+			auto& u8_buf = loaded.buffers.u8;
+			u8_buf.clear();
+			transcode(WideSource(loaded.buffers.wide), Utf8Sink(u8_buf), newline_style::preserve);
+			loaded.answer = tab_page_ptr_->answer_cache().intern(std::move(u8_buf)); // moved only if it's new
+		}
 
-			return static_cast<int>(line_diff_sign::done);
+		void AnswerFileBoxUnit::_post_show_file(LoadedFile& loaded)
+		{
+			shared_answer_ = std::move(loaded.answer);
+
+			// the answer typed before isn't needed anymore
+			answer_index_.clear();
+			answer_index_is_valid_ = false;
+			std::string().swap(typed_answer_);
 		}
 
-		color OutputFileBoxUnit::_line_num_color(unsigned int num) noexcept
+		void AnswerFileBoxUnit::_post_textbox_edited(bool is_edited) noexcept
 		{
-			if (!did_line_diff_ || num >= line_diff_results_.size())
-				return k_line_num_default_color;
-			if (line_diff_results_[num])
-				return colors::yellow_green;
-			return colors::orange_red;
+			if (is_edited)
+			{
+				shared_answer_.reset(); // the edited answer isn't the file's anymore
+				is_typed_ = true;
+				answer_index_is_valid_ = false;
+				tab_page_ptr_->output_box_line_diff();
+				_reset_textbox_edited();
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+﻿#include "gui.hpp"
+
+#include <cstdio>
+
+using namespace nana;
+
+namespace text_overseer
+{
+	namespace gui
+	{
+		namespace
+		{
+			// the columns except the name, which takes the rest of the width
+			struct Column
+			{
+				const char*		title;
+				unsigned int	width;
+			};
+
+			constexpr std::array<Column, 5> k_columns{ {
+				{ u8"최근 변경", 110 },
+				{ u8"입력 크기", 80 },
+				{ u8"출력 크기", 80 },
+				{ u8"입력 인코딩", 110 },
+				{ u8"결과", 50 }
+			} };
+
+			constexpr int k_text_margin = 4;
+
+			std::string size_to_string(std::uint64_t size)
+			{
+				char buf[32];
+				if (size < 1024)
+					std::snprintf(buf, sizeof(buf), "%u B", static_cast<unsigned int>(size));
+				else if (size < 1024 * 1024)
+					std::snprintf(buf, sizeof(buf), "%.1f KB", size / 1024.0);
+				else
+					std::snprintf(buf, sizeof(buf), "%.1f MB", size / (1024.0 * 1024.0));
+				return buf;
+			}
+		}
+
+		void IOCaseTable::push_back(std::string name)
+		{
+			names.push_back(std::move(name));
+			last_changes.push_back(file_system::TimePointOfSys());
+			input_sizes.push_back(0);
+			output_sizes.push_back(0);
+			input_encodings.push_back(file_io::FileIO::encoding::unknown);
+			verdicts.push_back(case_verdict::unknown);
+		}
+
+		void IOCaseTable::erase(std::size_t pos)
+		{
+			names.erase(names.begin() + pos);
+			last_changes.erase(last_changes.begin() + pos);
+			input_sizes.erase(input_sizes.begin() + pos);
+			output_sizes.erase(output_sizes.begin() + pos);
+			input_encodings.erase(input_encodings.begin() + pos);
+			verdicts.erase(verdicts.begin() + pos);
+		}
+
+		DashboardBox::DashboardBox(MainWindow& parent_main_window, const IOCaseTable& table)
+			: panel<true>(parent_main_window), table_ptr_(&table), main_window_ptr_(&parent_main_window)
+		{
+			place_.div("<vert <<canvas> <weight=16 scroll>> <weight=28 margin=[3, 0, 0, 0] <> <weight=120 btn_export>>>");
+			place_["canvas"] << canvas_;
+			place_["scroll"] << scroll_;
+			place_["btn_export"] << btn_export_;
+			place_.collocate();
+
+			canvas_.bgcolor(colors::white);
+
+			drawing{ canvas_ }.draw([this](paint::graphics& graph) {
+				this->_draw(graph);
+			});
+
+			// make events
+			scroll_.events().value_changed([this] {
+				this->refresh();
+			});
+
+			canvas_.events().mouse_wheel([this](const arg_wheel& arg) {
+				if (this->scroll_.make_step(!arg.upwards, 3))
+					this->refresh();
+			});
+
+			canvas_.events().resized([this] {
+				this->update_rows();
+			});
+
+			canvas_.events().dbl_click([this](const arg_mouse& arg) {
+				const auto row = this->_row_at(arg.pos.y);
+				if (row < this->table_ptr_->size())
+					this->main_window_ptr_->show_io_tab(row);
+			});
+
+			btn_export_.events().click([this] {
+				this->main_window_ptr_->export_report();
+			});
+		}
+
+		void DashboardBox::show_export_progress(std::size_t done, std::size_t total)
+		{
+			if (done >= total)
+			{
+				btn_export_.caption(u8"결과 내보내기");
+				btn_export_.enabled(true);
+				return;
+			}
+
+			char buf[48];
+			std::snprintf(buf, sizeof(buf), u8"내보내는 중 %u%%", static_cast<unsigned int>(done * 100 / total));
+			btn_export_.caption(buf);
+			btn_export_.enabled(false);
+		}
+
+		void DashboardBox::update_rows() noexcept
+		{
+			// the scroll bar counts the rows, not the pixels
+			const auto row_count = table_ptr_->size();
+			const auto visible_count = _visible_row_count();
+			scroll_.amount(row_count);
+			scroll_.range(visible_count);
+			scroll_.step(1);
+			if (scroll_.value() + visible_count > row_count)
+				scroll_.value(row_count > visible_count ? row_count - visible_count : 0);
+			refresh();
+		}
+
+		void DashboardBox::_draw(paint::graphics& graph) const
+		{
+			const auto& table = *table_ptr_;
+			const auto width = graph.width();
+
+			unsigned int fixed_width = 0;
+			for (const auto& column : k_columns)
+				fixed_width += column.width;
+			const auto name_width = width > fixed_width ? width - fixed_width : 0;
+
+			// a cell is drawn over the overflowed text of the former cell, so the texts are clipped in effect
+			const auto draw_row = [&](int top, const std::array<std::string, k_columns.size() + 1>& texts,
+				const color& bgcolor, const color& verdict_color)
+			{
+				auto left = 0;
+				for (std::size_t i = 0; i < texts.size(); i++)
+				{
+					graph.rectangle({ left, top, width - left, k_row_height }, true, bgcolor);
+					const auto& text_color = i == texts.size() - 1 ? verdict_color : color(colors::black);
+					graph.string({ left + k_text_margin, top + 3 }, texts[i], text_color);
+					left += i == 0 ? name_width : k_columns[i - 1].width;
+				}
+			};
+
+			// the header
+			std::array<std::string, k_columns.size() + 1> texts;
+			texts[0] = u8"폴더";
+			for (std::size_t i = 0; i < k_columns.size(); i++)
+				texts[i + 1] = k_columns[i].title;
+			draw_row(0, texts, colors::light_gray, colors::black);
+
+			// only the rows in view
+			const auto now = std::chrono::system_clock::now();
+			const auto first_row = scroll_.value();
+			const auto last_row = std::min(table.size(), first_row + _visible_row_count());
+			auto top = static_cast<int>(k_row_height);
+
+			for (auto row = first_row; row < last_row; row++)
+			{
+				texts[0] = table.names[row];
+				if (table.last_changes[row].time_since_epoch().count() == 0)
+				{
+					texts[1] = "-";
+				}
+				else
+				{
+					texts[1] = file_system::time_duration_to_string(
+						std::chrono::duration_cast<std::chrono::seconds>(now - table.last_changes[row]),
+						true,
+						file_system::time_period_strings::k_korean_u8
+					) + u8"전";
+				}
+				texts[2] = size_to_string(table.input_sizes[row]);
+				texts[3] = size_to_string(table.output_sizes[row]);
+
+				const auto encoding = table.input_encodings[row];
+				texts[4] = encoding == file_io::FileIO::encoding::unknown
+					? "-" : k_encoding_names[static_cast<std::size_t>(encoding)];
+
+				color verdict_color = colors::black;
+				switch (table.verdicts[row])
+				{
+				case case_verdict::passed:
+					texts[5] = u8"통과";
+					verdict_color = colors::green;
+					break;
+				case case_verdict::failed:
+					texts[5] = u8"실패";
+					verdict_color = colors::red;
+					break;
+				default:
+					texts[5] = "-";
+				}
+
+				draw_row(top, texts, row % 2 == 0 ? color(colors::white) : color(colors::alice_blue), verdict_color);
+				top += k_row_height;
+			}
+		}
+
+		std::size_t DashboardBox::_row_at(int y) const noexcept
+		{
+			if (y < static_cast<int>(k_row_height)) // the header
+				return table_ptr_->size();
+			const auto row = scroll_.value() + static_cast<std::size_t>(y) / k_row_height - 1;
+			return std::min(row, table_ptr_->size());
+		}
+
+		std::size_t DashboardBox::_visible_row_count() const noexcept
+		{
+			const auto height = canvas_.size().height;
+			return height > k_row_height ? (height - k_row_height) / k_row_height : 0;
+		}
+	}
+}
\ No newline at end of file
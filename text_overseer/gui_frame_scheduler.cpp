@@ -0,0 +1,123 @@
+﻿#include "gui.hpp"
+
+using namespace nana;
+
+namespace text_overseer
+{
+	namespace gui
+	{
+		FrameScheduler::FrameScheduler()
+		{
+			timer_.interval(k_ms_gui_timer_interval);
+			timer_.elapse([this](const nana::arg_elapse&) {
+				this->_tick();
+			});
+			// the timer doesn't start until a task gets dirty
+		}
+
+		FrameScheduler::task_id FrameScheduler::add_task(window owner, task_func func)
+		{
+			task_id id;
+			if (free_ids_.empty())
+			{
+				id = tasks_.size();
+				tasks_.push_back(Task{ owner, std::move(func), false, false });
+			}
+			else
+			{
+				id = free_ids_.back();
+				free_ids_.pop_back();
+				tasks_[id] = Task{ owner, std::move(func), false, false };
+			}
+			return id;
+		}
+
+		void FrameScheduler::remove_task(task_id id) noexcept
+		{
+			if (id >= tasks_.size() || tasks_[id].is_removed)
+				return;
+			auto& task = tasks_[id];
+			task.is_removed = true;
+			task.owner = nullptr;
+			if (id == servicing_id_)
+				return; // a task is removing itself; _tick() will release it after the call
+			task.func = nullptr;
+			if (!task.is_dirty) // a dirty one will be released when _tick() pops it
+				free_ids_.push_back(id);
+		}
+
+		void FrameScheduler::mark_dirty(task_id id) noexcept
+		{
+			if (id >= tasks_.size())
+				return;
+			auto& task = tasks_[id];
+			if (task.is_removed || task.is_dirty)
+				return;
+			task.is_dirty = true;
+			dirty_ids_.push_back(id);
+			if (!timer_.started())
+				timer_.start();
+		}
+
+		void FrameScheduler::wake(window owner) noexcept
+		{
+			for (task_id id = 0; id < tasks_.size(); id++)
+			{
+				if (tasks_[id].owner == owner)
+					mark_dirty(id);
+			}
+		}
+
+		bool FrameScheduler::_is_owner_shown(window owner) const noexcept
+		{
+			return owner != nullptr && API::visible(owner) && API::window_enabled(owner);
+		}
+
+		void FrameScheduler::_tick() noexcept
+		{
+			servicing_ids_.clear();
+			servicing_ids_.swap(dirty_ids_); // tasks marked dirty while servicing are queued for the next frame
+
+			for (const auto id : servicing_ids_)
+			{
+				auto& task = tasks_[id];
+				task.is_dirty = false;
+
+				if (task.is_removed)
+				{
+					free_ids_.push_back(id);
+					continue;
+				}
+
+				// a hidden owner costs nothing; wake() will queue its tasks again when it's shown
+				if (!_is_owner_shown(task.owner))
+					continue;
+
+				auto do_continue = false;
+				servicing_id_ = id;
+				try
+				{
+					do_continue = task.func();
+				}
+				catch (std::exception&)
+				{
+					// do nothing
+				}
+				servicing_id_ = k_no_task;
+
+				if (task.is_removed) // removed itself while being serviced
+				{
+					task.func = nullptr;
+					free_ids_.push_back(id);
+				}
+				else if (do_continue)
+				{
+					mark_dirty(id);
+				}
+			}
+
+			if (dirty_ids_.empty())
+				timer_.stop();
+		}
+	}
+}
\ No newline at end of file
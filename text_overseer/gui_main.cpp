@@ -9,7 +9,10 @@
 #include "resources.hpp"
 #include "version.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
+#include <sstream>
 
 using namespace nana;
 
@@ -20,7 +23,32 @@ namespace text_overseer
 
 	namespace gui
 	{
-		IOFilesTabPage::IOFilesTabPage(window wd) : panel<true>(wd)
+		namespace
+		{
+			// marks the io tabs being changed; the events raised meanwhile by the widgets see the flag
+			class IOTabChangeGuard
+			{
+			public:
+				explicit IOTabChangeGuard(bool& is_changing) : is_changing_(&is_changing) { *is_changing_ = true; }
+				~IOTabChangeGuard() { release(); }
+
+				IOTabChangeGuard(const IOTabChangeGuard& src) = delete;
+				IOTabChangeGuard& operator=(const IOTabChangeGuard& rhs) = delete;
+
+				void release() noexcept
+				{
+					if (is_changing_ != nullptr)
+						*is_changing_ = false;
+					is_changing_ = nullptr;
+				}
+
+			private:
+				bool* is_changing_;
+			};
+		}
+
+		IOFilesTabPage::IOFilesTabPage(window wd, FrameScheduler& frame_scheduler, line_diff::AnswerCache& answer_cache)
+			: panel<true>(wd), frame_scheduler_ptr_(&frame_scheduler), answer_cache_ptr_(&answer_cache)
 		{
 			place_.div(
 				"<"
@@ -39,26 +67,27 @@ namespace text_overseer
 		void IOFilesTabPage::output_box_line_diff()
 		{
 			const auto time_start = std::chrono::high_resolution_clock::now();
-			const auto result = output_box_.line_diff_between_answer(answer_box_.textbox_caption());
+			const auto result = output_box_.line_diff_between_answer(answer_box_.answer_index());
 			const auto time_end = std::chrono::high_resolution_clock::now();
+			last_diff_result_ = result;
 
 			std::ostringstream oss;
 
-			switch (result)
+			switch (result.status)
 			{
-			case static_cast<int>(OutputFileBoxUnit::line_diff_sign::error):
+			case line_diff::diff_status::error:
 				answer_box_.label_caption(
 					u8"<size=8>위에 정답 출력을 입력하면, 자동으로 출력 파일과 비교합니다.</>"
 				);
 				answer_box_.reset_line_count_of_file();
 				return;
-			case static_cast<int>(OutputFileBoxUnit::line_diff_sign::done):
+			case line_diff::diff_status::done:
 				oss << u8"<green>비교가 끝났습니다.</>\n";
 				answer_box_.reset_line_count_of_file();
 				break;
-			default:
+			case line_diff::diff_status::file_shorter:
 				oss << u8"<red>파일이 더 짧습니다!</>\n";
-				answer_box_.set_line_count_of_file(static_cast<std::size_t>(result));
+				answer_box_.set_line_count_of_file(result.first_unmatched_answer_line);
 			}
 
 			// add the duration string
@@ -73,6 +102,52 @@ namespace text_overseer
 			answer_box_.refresh_textbox_line_num();
 		}
 
+		bool IOTabDescriptor::is_same_files(const file_system::IOFilePaths& paths) const noexcept
+		{
+			const auto is_same_path = [](const std::wstring& lhs, const std::wstring& rhs) {
+				return lhs == rhs || file_system::filesys::path(lhs).compare(file_system::filesys::path(rhs)) == 0;
+			};
+			return is_same_path(file_paths.input, paths.input)
+				&& is_same_path(file_paths.output, paths.output)
+				&& is_same_path(file_paths.answer, paths.answer);
+		}
+
+		bool IOTabDescriptor::update_stamps(const file_system::FileStatResult* stats) noexcept
+		{
+			auto is_changed = false;
+			for (std::size_t i = 0; i < stamps.size(); i++)
+			{
+				const auto& stamp = stats[i].stamp;
+				if (stats[i].ec || !stamp.is_known() || stamp == stamps[i])
+					continue; // an unknown stamp is e.g. of a change held back by the coalescer
+				stamps[i] = stamp;
+				is_changed = true;
+			}
+			return is_changed;
+		}
+
+		case_verdict IOFilesTabPage::verdict() const noexcept
+		{
+			switch (last_diff_result_.status)
+			{
+			case line_diff::diff_status::done:
+				return last_diff_result_.different_line_count == 0 ? case_verdict::passed : case_verdict::failed;
+			case line_diff::diff_status::file_shorter:
+				return case_verdict::failed;
+			default:
+				return case_verdict::unknown;
+			}
+		}
+
+		MemoryUsage IOFilesTabPage::memory_usage() const noexcept
+		{
+			MemoryUsage usage;
+			input_box_.add_memory_usage(usage);
+			output_box_.add_memory_usage(usage);
+			answer_box_.add_memory_usage(usage);
+			return usage;
+		}
+
 		WelcomeBox::WelcomeBox(MainWindow& parent_main_window)
 			: panel<true>(parent_main_window), main_window_ptr_(&parent_main_window)
 		{
@@ -155,9 +230,13 @@ namespace text_overseer
 			main_window_ptr_->search_io_files();
 		}
 
-		MainWindow::MainWindow()
-			: form(API::make_center(640, 400), appear::decorate<appear::sizable, appear::minimize>())
+		MainWindow::MainWindow(const StartupTrace& startup_trace)
+			: form(API::make_center(640, 400), appear::decorate<appear::sizable, appear::minimize>()),
+			startup_trace_(startup_trace)
 		{
+			if (startup_trace_.is_enabled)
+				ErrorHdr::instance().start(); // the trace is written to the log file
+
 			// set the form's title
 			caption(std::string(u8"Text I/O File Overseer v") + k_version_str);
 			// set minimum window size
@@ -172,26 +251,32 @@ namespace text_overseer
 				"      <weight=18 margin=[0, 0, 2, 5] lab_title>"
 				"      <margin=[0, 0, 4, 12] lab_description>"
 				"    >"
-				"    <weight=150 margin=[0, 0, 0, 3] btn_refresh>"
+				"    <weight=150 margin=[0, 0, 0, 3] "
+				"      <vert <btn_refresh> <weight=3> <weight=24 btn_dashboard> >"
+				"    >"
 				"  >"
 				"  <weight=25 tabbar>"
 				"  <tab_frame>"
+				"  <dashboard>"
 				">"
 			);
 			place_["pic_logo"] << pic_logo_;
 			place_["lab_title"] << lab_title_;
 			place_["lab_description"] << lab_description_;
 			place_["btn_refresh"] << btn_refresh_;
+			place_["btn_dashboard"] << btn_dashboard_;
+			place_["dashboard"] << dashboard_;
+			place_.field_display("dashboard", false);
 			place_["tabbar"] << tabbar_;
 			place_.collocate();
 
-			// widget initiation - picture
-			paint::image img_logo;
-			img_logo.open(&resources::k_overseer_bmp[0], resources::k_overseer_bmp.size());
-			pic_logo_.load(img_logo);
+			// widget initiation - picture (the logo is decoded after the window is shown)
 			pic_logo_.stretchable(false);
 			pic_logo_.align(align::center, align_v::center);
 
+			// widget initiation - welcome box (not placed until the search finds nothing)
+			welcome_box_.hide();
+
 			// widget initiation - label
 			lab_title_.format(true);
 			lab_description_.format(true);
@@ -199,128 +284,526 @@ namespace text_overseer
 			// initiation of tap pages
 			tabbar_.toolbox(tabbar<std::string>::kits::scroll, true);
 			tabbar_.toolbox(tabbar<std::string>::kits::list, true);
-			search_io_files();
+			search_io_files(); // the tabs come in on the timer ticks, after the window is shown
 
 			// make events and etc.
 			_make_events();
 			_make_timer_io_tab_state();
 		}
 
-		void MainWindow::search_io_files() noexcept
+		void MainWindow::export_report() noexcept
 		{
-			std::lock_guard<std::mutex> g(io_tab_mutex_);
+			if (is_changing_io_tabs_ || is_exporting_report_)
+				return;
+			IOTabChangeGuard guard(is_changing_io_tabs_);
 
-			// preserve the condition of timer_io_tab_state_
-			const auto timer_io_tab_state_was_going = timer_io_tab_state_.started();
-			timer_io_tab_state_.stop();
+			try
+			{
+				export_cases_.assign(io_tabs_.size(), report::CaseSnapshot());
+				export_file_paths_.clear();
+				for (std::size_t i = 0; i < io_tabs_.size(); i++)
+				{
+					const auto& tab = io_tabs_[i];
+					auto& snapshot = export_cases_[i];
+					snapshot.name = io_cases_.names[i];
+					snapshot.input_encoding = static_cast<std::uint8_t>(io_cases_.input_encodings[i]);
+					snapshot.verdict = static_cast<std::uint8_t>(io_cases_.verdicts[i]);
+					export_file_paths_.push_back(tab.file_paths); // fingerprinted by _step_export_report()
 
-			// _remove_tabbar_color_animation() for all tabbar_color_animations_
-			for (std::size_t i = 0; i < tabbar_color_animations_.size(); i++)
-				_remove_tabbar_color_animation(i);
+					// an evicted page left its results in the descriptor
+					const auto& result = tab.page ? tab.page->last_diff_result() : tab.evicted_diff_result;
+					snapshot.line_count = result.file_line_count;
+					snapshot.different_line_count = result.different_line_count;
+					if (!tab.page)
+						snapshot.run_lengths = tab.evicted_diff_runs;
+					else if (const auto results = tab.page->line_diff_results())
+						results->to_runs(snapshot.run_lengths);
+				}
+			}
+			catch (std::exception& e)
+			{
+				ErrorHdr::instance().report(
+					ErrorHdr::priority::critical, 0, std::string("Cannot export the report - ") + e.what()
+				);
+				guard.release();
+				_finish_export_report(false);
+				return;
+			}
 
-			auto pair_file_pairs_and_path_ecs = file_system::search_input_output_files(L"input.txt", L"output.txt");
-			auto file_pairs = std::move(pair_file_pairs_and_path_ecs.first);
-			const auto path_ecs = std::move(pair_file_pairs_and_path_ecs.second);
+			export_next_case_ = 0;
+			is_exporting_report_ = true;
+			dashboard_.show_export_progress(0, export_cases_.size());
+			guard.release();
+			_step_export_report(); // the first slice, or the whole report if it's small
+		}
 
-			// check error codes from file_system::search_input_output_files()
-			for (const auto& path_ec : path_ecs)
+		void MainWindow::_step_export_report() noexcept
+		{
+			if (!is_exporting_report_)
+				return;
+
+			const auto total = export_cases_.size();
+			const auto time_start = std::chrono::steady_clock::now();
+			auto is_failed = false;
+			do
+			{
+				// the files of a slice are read and hashed on the workers, whose I/O latency overlaps
+				const auto first = export_next_case_;
+				const auto count = std::min(k_export_cases_per_slice, total - first);
+				std::atomic<bool> has_error{ false };
+				batch_io_.run_all(count * IOFilesTabPage::k_file_box_count, [this, first, &has_error](std::size_t j) {
+					const auto& file_paths = this->export_file_paths_[first + j / IOFilesTabPage::k_file_box_count];
+					auto& snapshot = this->export_cases_[first + j / IOFilesTabPage::k_file_box_count];
+					try
+					{
+						std::string buf;
+						switch (j % IOFilesTabPage::k_file_box_count)
+						{
+						case 0:
+							snapshot.input = report::fingerprint_file(file_paths.input, buf);
+							break;
+						case 1:
+							snapshot.output = report::fingerprint_file(file_paths.output, buf);
+							break;
+						default:
+							if (!file_paths.answer.empty())
+								snapshot.answer = report::fingerprint_file(file_paths.answer, buf);
+						}
+					}
+					catch (std::exception&)
+					{
+						has_error = true;
+					}
+				});
+				export_next_case_ += count;
+
+				if (has_error)
+				{
+					ErrorHdr::instance().report(
+						ErrorHdr::priority::critical, 0, "Cannot export the report - a file couldn't be read entirely"
+					);
+					is_failed = true;
+					break;
+				}
+			} while (export_next_case_ < total
+				&& std::chrono::steady_clock::now() - time_start < std::chrono::milliseconds(k_ms_export_budget_per_tick));
+
+			if (is_failed)
+			{
+				_finish_export_report(false);
+				return;
+			}
+			if (export_next_case_ < total)
+			{
+				dashboard_.show_export_progress(export_next_case_, total);
+				return;
+			}
+
+			auto is_written = false;
+			try
+			{
+				is_written = report::write_report(k_report_filename, export_cases_);
+			}
+			catch (std::exception& e)
 			{
-				const auto ec = path_ec.error_code();
 				ErrorHdr::instance().report(
-					ErrorHdr::priority::info,
-					ec.value(),
-					std::string("Cannot open the path while file search - ")
-					+ charset(ec.message()).to_bytes(unicode::utf8),
-					wstr_to_utf8(path_ec.path_str())
+					ErrorHdr::priority::critical, 0, std::string("Cannot export the report - ") + e.what()
+				);
+			}
+			_finish_export_report(is_written);
+		}
+
+		void MainWindow::_finish_export_report(bool is_written) noexcept
+		{
+			is_exporting_report_ = false; // before showing the message box, whose loop runs the timer
+			std::vector<report::CaseSnapshot>().swap(export_cases_);
+			std::vector<file_system::IOFilePaths>().swap(export_file_paths_);
+			dashboard_.show_export_progress(0, 0);
+
+			if (is_written)
+			{
+				msgbox mb(*this, u8"결과 내보내기");
+				mb.icon(msgbox::icon_information) << u8"모든 테스트 결과를 내보냈습니다.\n" << k_report_filename;
+				mb.show();
+			}
+			else
+			{
+				msgbox mb(*this, u8"결과 내보내기 실패");
+				mb.icon(msgbox::icon_error) << u8"결과 파일을 쓰는 데 실패했습니다.";
+				mb.show();
+			}
+		}
+
+		void MainWindow::search_io_files() noexcept
+		{
+			if (is_changing_io_tabs_)
+				return;
+			IOTabChangeGuard guard(is_changing_io_tabs_);
+
+			try
+			{
+				// the tabs not found again will be erased when the search is done
+				// they're indexed, so each case found is matched without going through all the tabs
+				io_tab_positions_.clear();
+				for (std::size_t i = 0; i < io_tabs_.size(); i++)
+				{
+					io_tabs_[i].is_found = false;
+					io_tab_positions_.emplace(_io_tab_key(io_tabs_[i].file_paths), i);
+				}
+
+				io_file_search_.start(_load_io_file_patterns());
+				is_searching_io_files_ = true;
+			}
+			catch (std::exception& e)
+			{
+				ErrorHdr::instance().report(
+					ErrorHdr::priority::critical, 0, std::string("Cannot start the file search - ") + e.what()
 				);
 			}
+		}
+
+		void MainWindow::_take_found_io_files() noexcept
+		{
+			if (!is_searching_io_files_ || is_changing_io_tabs_)
+				return;
+			IOTabChangeGuard guard(is_changing_io_tabs_);
 
-			// check if tab pages found already exists
-			for (std::size_t i = 0; i < io_tab_pages_.size(); i++)
+			auto is_done = false;
+			try
 			{
-				auto are_already_in_tabs = false;
+				is_done = io_file_search_.take(found_io_files_, found_path_ecs_);
+			}
+			catch (std::exception&)
+			{
+				return; // try again on the next tick
+			}
 
-				for (std::size_t j = 0; j < file_pairs.size(); j++)
+			// the tabs of the folders found so far
+			for (const auto& file_paths : found_io_files_)
+			{
+				IOTabDescriptor* tab = nullptr;
+				try
 				{
-					if (io_tab_pages_[i]->is_same_files(file_pairs[j].first, file_pairs[j].second))
-					{
-						are_already_in_tabs = true;
-						file_pairs.erase(file_pairs.begin() + j);
-						break;
-					}
+					const auto it = io_tab_positions_.find(_io_tab_key(file_paths));
+					if (it != io_tab_positions_.end() && !io_tabs_[it->second].is_found
+						&& io_tabs_[it->second].is_same_files(file_paths))
+						tab = &io_tabs_[it->second];
+				}
+				catch (std::exception&)
+				{
+					// a new tab is made for it, and the old one is erased at the end
 				}
 
-				if (are_already_in_tabs)
+				if (tab != nullptr)
 				{
-					io_tab_pages_[i]->reload_files();
+					tab->is_found = true;
+					if (tab->page) // a tab not materialized will read the files when it's activated
+						tab->page->reload_files();
 				}
 				else
 				{
-					tabbar_.erase(i); // it will change current activated tab; but can't manage to handle this
-					place_.erase(*io_tab_pages_[i]);
-					io_tab_pages_.erase(io_tab_pages_.begin() + i--);
+					_create_io_tab(_io_tab_name(file_paths), file_paths);
+					tabbar_color_animator_.start(io_tabs_.size() - 1);
 				}
 			}
 
-			// get the folder names and _create_io_tab_page()
-			for (auto& file_pair : file_pairs)
+			if (!found_io_files_.empty())
 			{
-				const auto before_last_slash = file_pair.first.find_last_of(L"/\\") - 1;
-				const auto after_second_last_slash = file_pair.first.find_last_of(L"/\\", before_last_slash) + 1;
-				auto folder_wstr = file_pair.first.substr(
-					after_second_last_slash,
-					before_last_slash - after_second_last_slash + 1
-				);
-				if (folder_wstr.empty())
-					folder_wstr = L"root";
-				_create_io_tab_page(
-					charset(std::move(folder_wstr)).to_bytes(unicode::utf8),
-					std::move(file_pair.first),
-					std::move(file_pair.second)
+				_show_welcome_box(false);
+				const auto activated = tabbar_.activated();
+				if (activated < io_tabs_.size() && !io_tabs_[activated].page)
+					_activate_io_tab(activated); // only the page of the activated tab is made
+				dashboard_.update_rows();
+			}
+
+			if (!is_done)
+				return;
+
+			is_searching_io_files_ = false;
+			io_tab_positions_.clear(); // the positions are going to change
+
+			// check error codes from the search
+			for (const auto& path_ec : found_path_ecs_)
+			{
+				const auto ec = path_ec.error_code();
+				ErrorHdr::instance().report(
+					ErrorHdr::priority::info,
+					ec.value(),
+					std::string("Cannot open the path while file search - ")
+					+ charset(ec.message()).to_bytes(unicode::utf8),
+					wstr_to_utf8(path_ec.path_str())
 				);
 			}
 
-			if (!io_tab_pages_.empty())
+			// erase the tabs not found again; the tab positions are going to change
+			tabbar_color_animator_.clear();
+			for (std::size_t i = 0; i < io_tabs_.size(); i++)
 			{
-				place_.erase(welcome_box_); // erase the welcome box
-				welcome_box_.hide();
-				// make io tab pages not enabled except the activated one
-				_make_io_tabs_not_enabled_except_one(tabbar_.activated());
+				if (io_tabs_[i].is_found)
+					continue;
+				tabbar_.erase(i); // it will change current activated tab; but can't manage to handle this
+				if (io_tabs_[i].page)
+					place_.erase(*io_tabs_[i].page);
+				io_tabs_.erase(io_tabs_.begin() + i);
+				io_cases_.erase(i--);
+			}
+
+			if (!io_tabs_.empty())
+			{
+				_show_welcome_box(false);
+				_activate_io_tab(tabbar_.activated());
 			}
 			else
 			{
-				place_["tab_frame"].fasten(welcome_box_); // add the welcome box
-				welcome_box_.show();
+				_show_welcome_box(true);
 				API::refresh_window(tabbar_); // refresh the tabbar
 			}
 
 			// update nana::place
 			place_.collocate();
+			dashboard_.update_rows();
+
+			// start the color animations for all tabs
+			for (std::size_t i = 0; i < io_tabs_.size(); i++)
+				tabbar_color_animator_.start(i);
 
-			// restore the condition of timer_io_tab_state_
-			if (timer_io_tab_state_was_going)
-				timer_io_tab_state_.start();
+			_trace_startup("all tabs");
 
-			// _make_tabbar_color_animation() for all tabs
-			for (std::size_t i = 0; i < io_tab_pages_.size(); i++)
-				_make_tabbar_color_animation(i);
+			if (do_notify_no_io_files_)
+			{
+				do_notify_no_io_files_ = false;
+				if (io_tabs_.empty())
+				{
+					guard.release(); // before showing the message box, whose loop runs the timer
+					msgbox mb(*this, u8"검색 결과 없음");
+					mb.icon(msgbox::icon_information) << u8"input.txt나 output.txt 파일을 찾지 못했습니다.";
+					mb.show();
+				}
+			}
+		}
+
+		std::wstring MainWindow::_io_tab_key(const file_system::IOFilePaths& file_paths)
+		{
+			// the generic form, so the separators don't matter; the files are compared by is_same_files() after all
+			const auto& path_str = file_paths.input.empty() ? file_paths.output : file_paths.input;
+			return file_system::filesys::path(path_str).generic_wstring();
+		}
+
+		std::string MainWindow::_io_tab_name(const file_system::IOFilePaths& file_paths)
+		{
+			// the name of the folder, and the key of the case if the folder can have many(e.g. probA/1)
+			const auto before_last_slash = file_paths.input.find_last_of(L"/\\") - 1;
+			const auto after_second_last_slash = file_paths.input.find_last_of(L"/\\", before_last_slash) + 1;
+			auto folder_wstr = file_paths.input.substr(
+				after_second_last_slash,
+				before_last_slash - after_second_last_slash + 1
+			);
+			if (folder_wstr.empty())
+				folder_wstr = L"root";
+			if (!file_paths.key.empty())
+				folder_wstr += L'/' + file_paths.key;
+			return charset(std::move(folder_wstr)).to_bytes(unicode::utf8);
+		}
+
+		void MainWindow::_show_welcome_box(bool is_shown) noexcept
+		{
+			if (is_welcome_box_shown_ == is_shown)
+				return;
+			is_welcome_box_shown_ = is_shown;
+			if (is_shown)
+			{
+				place_["tab_frame"].fasten(welcome_box_); // add the welcome box
+				welcome_box_.show();
+			}
+			else
+			{
+				place_.erase(welcome_box_); // erase the welcome box
+				welcome_box_.hide();
+			}
 		}
 
-		void MainWindow::_create_io_tab_page(
-			std::string tab_name_u8,
-			std::wstring input_filename,
-			std::wstring output_filename
-		) noexcept
+		void MainWindow::_load_logo() noexcept
+		{
+			paint::image img_logo;
+			img_logo.open(&resources::k_overseer_bmp[0], resources::k_overseer_bmp.size());
+			pic_logo_.load(img_logo);
+		}
+
+		void MainWindow::_trace_startup(const char* milestone) noexcept
+		{
+			if (!startup_trace_.is_enabled)
+				return;
+			if (std::strcmp(milestone, "all tabs") == 0)
+			{
+				if (did_trace_all_tabs_)
+					return; // only the first search is a part of the startup
+				did_trace_all_tabs_ = true;
+			}
+			try
+			{
+				const auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - startup_trace_.start_time
+				).count();
+				std::ostringstream oss;
+				oss << "Startup trace - time to " << milestone << ": " << msecs << " ms, " << io_tabs_.size() << " tabs";
+				ErrorHdr::instance().report(ErrorHdr::priority::info, 0, oss.str());
+			}
+			catch (std::exception&)
+			{
+				// do nothing
+			}
+		}
+
+		std::vector<file_system::IOFilePatterns> MainWindow::_load_io_file_patterns() noexcept
+		{
+			try
+			{
+				FileIO file(k_io_file_patterns_filename);
+				if (file.open(std::ios::in | std::ios::binary))
+				{
+					FileIOClosingGuard file_closer(file);
+					std::string bytes;
+					std::wstring text;
+					if (read_text(file, bytes, WideSink(text), newline_style::lf) == FileIO::encoding::unknown)
+						throw std::runtime_error("cannot read the file");
+
+					auto patterns = file_system::parse_io_file_patterns(text);
+					if (!patterns.empty())
+						return patterns;
+				}
+			}
+			catch (std::exception& e)
+			{
+				ErrorHdr::instance().report(
+					ErrorHdr::priority::info, 0,
+					std::string("Cannot read the filename patterns - ") + e.what(),
+					wstr_to_utf8(k_io_file_patterns_filename)
+				);
+			}
+			return file_system::k_default_io_file_patterns;
+		}
+
+		void MainWindow::_activate_io_tab(std::size_t pos) noexcept
+		{
+			if (pos >= io_tabs_.size())
+				return;
+
+			auto& tab = io_tabs_[pos];
+			tab.last_activated = ++io_tab_activation_count_;
+			if (!tab.page)
+			{
+				try
+				{
+					_materialize_io_tab_page(pos);
+				}
+				catch (std::exception& e)
+				{
+					ErrorHdr::instance().report(
+						ErrorHdr::priority::critical, 0,
+						std::string("Cannot make the tab page - ") + e.what(),
+						wstr_to_utf8(tab.file_paths.input)
+					);
+					return;
+				}
+			}
+
+			_make_io_tabs_not_enabled_except_one(pos);
+			_evict_io_tab_pages(pos);
+			_report_memory_usage();
+		}
+
+		void MainWindow::_create_io_tab(std::string tab_name_u8, const file_system::IOFilePaths& file_paths) noexcept
+		{
+			// the page isn't made until the tab is activated
+			IOTabDescriptor tab;
+			tab.file_paths = file_paths;
+			io_cases_.push_back(tab_name_u8);
+			tabbar_.push_back(std::move(tab_name_u8));
+			const auto pos = io_tabs_.size();
+			tabbar_.tab_bgcolor(pos, colors::white);
+			io_tabs_.push_back(std::move(tab));
+		}
+
+		void MainWindow::_evict_io_tab_pages(std::size_t active_pos) noexcept
+		{
+			auto live_count = std::count_if(io_tabs_.begin(), io_tabs_.end(), [](const IOTabDescriptor& tab) {
+				return tab.page != nullptr;
+			});
+
+			while (static_cast<std::size_t>(live_count) > k_max_live_io_tab_pages)
+			{
+				// the least recently activated one, which has nothing to lose
+				IOTabDescriptor* lru_tab = nullptr;
+				for (std::size_t i = 0; i < io_tabs_.size(); i++)
+				{
+					auto& tab = io_tabs_[i];
+					if (i == active_pos || !tab.page || tab.page->has_unsaved_text())
+						continue;
+					if (lru_tab == nullptr || tab.last_activated < lru_tab->last_activated)
+						lru_tab = &tab;
+				}
+				if (lru_tab == nullptr)
+					break;
+
+				// keep the line results for the report; they're compact as runs
+				lru_tab->evicted_diff_result = lru_tab->page->last_diff_result();
+				lru_tab->evicted_diff_runs.clear();
+				try
+				{
+					if (const auto results = lru_tab->page->line_diff_results())
+						results->to_runs(lru_tab->evicted_diff_runs);
+				}
+				catch (std::exception&)
+				{
+					lru_tab->evicted_diff_result = line_diff::LineDiffResult();
+					lru_tab->evicted_diff_runs.clear();
+				}
+
+				// the tabbar ignores the attached window after it's destroyed
+				place_.erase(*lru_tab->page);
+				lru_tab->page.reset();
+				live_count--;
+			}
+		}
+
+		void MainWindow::_materialize_io_tab_page(std::size_t pos)
 		{
 			// this function was made in the light of the nana example(widget_show.cpp)
-			auto page = std::make_shared<IOFilesTabPage>(*this);
-			page->register_files(input_filename, output_filename);
+			auto& tab = io_tabs_[pos];
+			auto page = std::make_shared<IOFilesTabPage>(*this, frame_scheduler_, answer_cache_);
+			page->register_files(tab.file_paths); // the files will be read on the next state update
 			place_["tab_frame"].fasten(*page);
-			tabbar_.push_back(std::move(tab_name_u8));
-			const auto pos = io_tab_pages_.size();
 			tabbar_.attach(pos, *page);
-			tabbar_.tab_bgcolor(pos, colors::white);
-			io_tab_pages_.push_back(std::move(page));
+			tab.page = std::move(page);
+			place_.collocate();
+		}
+
+		void MainWindow::_report_memory_usage() noexcept
+		{
+			if (!ErrorHdr::instance().is_started())
+				return;
+			try
+			{
+				MemoryUsage usage;
+				std::size_t page_count = 0;
+				for (const auto& tab : io_tabs_)
+				{
+					if (!tab.page)
+						continue;
+					usage += tab.page->memory_usage();
+					page_count++;
+				}
+
+				std::ostringstream oss;
+				oss << "Memory - " << page_count << " pages: " << usage.total() << " bytes (textboxes "
+					<< usage.widget_text << ", shared text " << usage.shared_text << ", buffers " << usage.buffers
+					<< ", line diff " << usage.line_diff << ")";
+				ErrorHdr::instance().report(ErrorHdr::priority::info, 0, oss.str());
+			}
+			catch (std::exception&)
+			{
+				// do nothing
+			}
 		}
 
 		void MainWindow::_easter_egg_logo() noexcept
@@ -381,21 +864,28 @@ namespace text_overseer
 
 			// btn_refresh_ is clicked => _search_io_files()
 			btn_refresh_.events().click([this](const arg_click&) {
+				this->do_notify_no_io_files_ = true; // show a message box if empty when the search is done
 				this->search_io_files();
-				// show a message box if empty
-				if (io_tab_pages_.empty())
-				{
-					msgbox mb(*this, u8"검색 결과 없음");
-					mb.icon(msgbox::icon_information) << u8"input.txt나 output.txt 파일을 찾지 못했습니다.";
-					mb.show();
-				}
 			});
 
-			tabbar_.events().activated([this](const arg_tabbar<std::string>& arg) {
-				std::unique_lock<std::mutex> lock(io_tab_mutex_, std::try_to_lock);
-				if (!lock)
+			// the window is shown => the resources not needed before it are loaded
+			this->events().expose([this](const arg_expose& arg) {
+				if (!arg.exposed || this->is_logo_loaded_)
 					return;
-				_make_io_tabs_not_enabled_except_one(arg.widget.activated());
+				this->is_logo_loaded_ = true;
+				this->_load_logo();
+				this->_trace_startup("first frame");
+			});
+
+			btn_dashboard_.events().click([this](const arg_click&) {
+				this->_show_dashboard(!this->is_dashboard_shown_);
+			});
+
+			tabbar_.events().activated([this](const arg_tabbar<std::string>& arg) {
+				if (this->is_changing_io_tabs_)
+					return; // raised by erasing a tab; the one to be activated is chosen after that
+				_show_dashboard(false);
+				_activate_io_tab(arg.widget.activated());
 			});
 
 			// trying to unload MainWindow => msgbox
@@ -405,7 +895,7 @@ namespace text_overseer
 				mb << u8"정말로 종료하시겠습니까?";
 				if (arg.cancel = (mb() == msgbox::pick_no))
 					return;
-				if (!io_tab_pages_.empty())
+				if (!io_tabs_.empty())
 				{
 					mb << u8"\n저장하지 않은 정보는 손실될 수 있습니다!\n\n종료하려면 '예'를 누르세요.";
 					arg.cancel = (mb() == msgbox::pick_no);
@@ -413,19 +903,79 @@ namespace text_overseer
 			});
 		}
 
+		void MainWindow::show_io_tab(std::size_t pos) noexcept
+		{
+			if (pos >= io_tabs_.size())
+				return;
+			_show_dashboard(false);
+			tabbar_.activated(pos);
+			_activate_io_tab(pos); // in case the event didn't happen for the already activated tab
+		}
+
+		void MainWindow::_show_dashboard(bool is_shown) noexcept
+		{
+			if (is_dashboard_shown_ == is_shown)
+				return;
+			is_dashboard_shown_ = is_shown;
+			place_.field_display("tab_frame", !is_shown);
+			place_.field_display("dashboard", is_shown);
+			btn_dashboard_.caption(is_shown ? u8"탭 보기" : u8"대시보드 보기");
+			place_.collocate();
+			if (is_shown)
+				dashboard_.update_rows();
+		}
+
+		void MainWindow::_update_io_case(std::size_t pos, bool is_changed) noexcept
+		{
+			auto& tab = io_tabs_[pos];
+
+			if (is_changed)
+			{
+				using file_system::FileStamp;
+				const auto latest = std::max_element(
+					tab.stamps.begin(), tab.stamps.end(), [](const FileStamp& lhs, const FileStamp& rhs) {
+						return lhs.mtime_ns < rhs.mtime_ns;
+					}
+				);
+				io_cases_.last_changes[pos] = latest->last_write_time();
+
+				// the sizes come with the stamps
+				io_cases_.input_sizes[pos] = tab.stamps[0].size;
+				io_cases_.output_sizes[pos] = tab.stamps[1].size;
+
+				if (!tab.page)
+				{
+					io_cases_.verdicts[pos] = case_verdict::unknown; // it'll be compared when the page is made
+					tab.evicted_diff_result = line_diff::LineDiffResult();
+					std::vector<std::uint64_t>().swap(tab.evicted_diff_runs);
+				}
+			}
+
+			if (tab.page)
+			{
+				io_cases_.input_encodings[pos] = tab.page->input_locale();
+				io_cases_.verdicts[pos] = tab.page->verdict();
+			}
+		}
+
 		void MainWindow::_make_io_tabs_not_enabled_except_one(std::size_t pos) noexcept
 		{
 			const auto tab_n = tabbar_.length();
 			for (std::size_t i = 0; i < tab_n; i++)
 			{
+				const auto& page = this->io_tabs_[i].page;
+				if (!page)
+					continue;
 				if (i == pos)
 				{
-					this->io_tab_pages_[i]->enabled(true);
-					API::refresh_window_tree(this->io_tab_pages_[i]->handle());
+					page->enabled(true);
+					API::refresh_window_tree(page->handle());
+					// the box units' frame tasks were skipped while the page was hidden
+					frame_scheduler_.wake(page->handle());
 				}
 				else
 				{
-					this->io_tab_pages_[i]->enabled(false);
+					page->enabled(false);
 				}
 			}
 		}
@@ -433,56 +983,177 @@ namespace text_overseer
 		void MainWindow::_make_timer_io_tab_state() noexcept
 		{
 			timer_io_tab_state_.elapse([this] {
-				const auto size = this->io_tab_pages_.size();
-				for (std::size_t i = 0; i < size; i++)
-				{
-					if (this->io_tab_pages_[i]->update_io_file_box_state())
-						this->_make_tabbar_color_animation(i);
-				}
+				this->_take_found_io_files();
+				this->_update_io_tab_states();
+				this->_step_export_report();
 			});
 			timer_io_tab_state_.interval(k_ms_update_label_state_interval);
 			timer_io_tab_state_.start();
 		}
 
-		void MainWindow::_make_tabbar_color_animation(std::size_t pos) noexcept
+		void MainWindow::_update_io_tab_states() noexcept
 		{
-			if (tabbar_color_animations_.size() <= pos)
-				tabbar_color_animations_.resize(pos + 1);
-
-			if (tabbar_color_animations_[pos].timer_ptr)
+			if (is_changing_io_tabs_)
 				return;
 
-			const auto func_color_level = [](unsigned int time) -> double {
-				if (time >= 400 && time <= 1600)
-					return 1.0 - static_cast<double>(time - 400) / 1200;
-				return 1.0;
-			};
+			// 1st batch: stat every watched file
+			watched_boxes_.clear();
+			watched_paths_.clear();
+			for (const auto& tab : io_tabs_)
+			{
+				if (tab.page)
+					tab.page->collect_io_file_boxes(watched_boxes_);
+				else
+					watched_boxes_.resize(watched_boxes_.size() + IOFilesTabPage::k_file_box_count, nullptr);
+				watched_paths_.push_back(&tab.file_paths.input);
+				watched_paths_.push_back(&tab.file_paths.output);
+				watched_paths_.push_back(&tab.file_paths.answer);
+			}
+			try
+			{
+				batch_io_.stat_all(watched_paths_, watched_stats_);
+			}
+			catch (std::exception&)
+			{
+				return; // try again on the next tick
+			}
+
+			// 2nd batch: read and decode the changed files which have settled
+			// a change still being written is held back; the box sees the stat of the file it shows till then
+			const auto now = file_system::ChangeCoalescer::clock::now();
+			changed_boxes_.clear();
+			for (std::size_t i = 0; i < watched_boxes_.size(); i++)
+			{
+				const auto box = watched_boxes_[i];
+				if (box == nullptr)
+					continue;
 
-			auto a_timer = std::make_shared<timer>();
-			a_timer->interval(k_ms_gui_timer_interval);
-			a_timer->elapse([this, pos, interval = a_timer->interval(), &func_color_level](const nana::arg_elapse&) {
-				auto& time = this->tabbar_color_animations_[pos].elapsed_time;
-				color color_leveled(color_rgb(0xff8c00)); // #ff8c00 dark orange
-				color_leveled = color_leveled.blend(colors::button_face, func_color_level(time));
-				this->tabbar_.tab_bgcolor(pos, color_leveled);
-				time += interval;
-				if (time >= 1600)
-					this->_remove_tabbar_color_animation(pos);
+				auto& coalescer = io_tabs_[i / IOFilesTabPage::k_file_box_count]
+					.change_coalescers[i % IOFilesTabPage::k_file_box_count];
+				const auto is_changed = box->is_file_changed(watched_stats_[i]);
+				const auto is_due = coalescer.update(
+					is_changed,
+					watched_stats_[i],
+					now,
+					std::chrono::milliseconds(k_ms_change_quiet_period),
+					std::chrono::milliseconds(k_ms_change_max_latency)
+				);
+
+				if (is_due)
+					changed_boxes_.push_back(box);
+				else if (is_changed)
+					watched_stats_[i] = box->shown_stat();
+			}
+			batch_io_.run_all(changed_boxes_.size(), [this](std::size_t i) {
+				this->changed_boxes_[i]->load_file();
 			});
 
-			auto& timer_data = tabbar_color_animations_[pos];
-			timer_data.timer_ptr = std::move(a_timer);
-			timer_data.elapsed_time = 0;
-			timer_data.timer_ptr->start();
+			// the widgets are updated here, on the GUI thread; a tab not materialized only keeps the times
+			const auto size = io_tabs_.size();
+			for (std::size_t i = 0; i < size; i++)
+			{
+				auto& tab = io_tabs_[i];
+				const auto stats = &watched_stats_[i * IOFilesTabPage::k_file_box_count];
+				const auto is_changed = tab.update_stamps(stats);
+				if (tab.page ? tab.page->update_io_file_box_state(stats) : is_changed)
+					tabbar_color_animator_.start(i);
+				_update_io_case(i, is_changed);
+			}
+
+			if (is_dashboard_shown_)
+				dashboard_.refresh(); // the rows in view only
 		}
 
-		void MainWindow::_remove_tabbar_color_animation(std::size_t pos) noexcept
+		TabbarColorAnimator::TabbarColorAnimator(
+			tabbar<std::string>&	tabbar_widget,
+			FrameScheduler&			frame_scheduler
+		) : tabbar_ptr_(&tabbar_widget), frame_scheduler_ptr_(&frame_scheduler)
 		{
-			auto& timer_data = tabbar_color_animations_[pos];
-			if (!timer_data.timer_ptr)
+			task_id_ = frame_scheduler.add_task(tabbar_widget, [this] {
+				return this->_step();
+			});
+		}
+
+		TabbarColorAnimator::~TabbarColorAnimator()
+		{
+			frame_scheduler_ptr_->remove_task(task_id_);
+		}
+
+		void TabbarColorAnimator::start(std::size_t pos)
+		{
+			if (is_animating_.size() <= pos)
+				is_animating_.resize(pos + 1, false);
+
+			if (is_animating_[pos])
 				return;
-			timer_data.timer_ptr->stop();
-			timer_data.timer_ptr.reset();
+
+			is_animating_[pos] = true;
+			positions_.push_back(pos);
+			elapsed_times_.push_back(0);
+			applied_levels_.push_back(-1);
+			frame_scheduler_ptr_->mark_dirty(task_id_);
+		}
+
+		void TabbarColorAnimator::clear() noexcept
+		{
+			positions_.clear();
+			elapsed_times_.clear();
+			applied_levels_.clear();
+			is_animating_.assign(is_animating_.size(), false);
+		}
+
+		double TabbarColorAnimator::_color_level(unsigned int time) noexcept
+		{
+			if (time >= 400 && time <= 1600)
+				return 1.0 - static_cast<double>(time - 400) / 1200;
+			return 1.0;
+		}
+
+		bool TabbarColorAnimator::_step() noexcept
+		{
+			const color dark_orange(color_rgb(0xff8c00)); // #ff8c00 dark orange
+
+			// step all the animations in one frame; tab_bgcolor() would repaint the tabbar for every tab,
+			// so the drawing is held off while the colors change, and the tabbar is repainted once
+			auto is_changed = false;
+			API::auto_draw(*tabbar_ptr_, false);
+
+			std::size_t i = 0;
+			while (i < positions_.size())
+			{
+				const auto color_level = _color_level(elapsed_times_[i]);
+				const auto level = static_cast<int>(color_level * k_tabbar_color_levels);
+
+				if (level != applied_levels_[i])
+				{
+					tabbar_ptr_->tab_bgcolor(positions_[i], dark_orange.blend(colors::button_face, color_level));
+					applied_levels_[i] = level;
+					is_changed = true;
+				}
+
+				elapsed_times_[i] += k_ms_gui_timer_interval;
+
+				if (elapsed_times_[i] >= 1600)
+				{
+					// remove the finished one by swapping it with the last one
+					is_animating_[positions_[i]] = false;
+					positions_[i] = positions_.back();
+					elapsed_times_[i] = elapsed_times_.back();
+					applied_levels_[i] = applied_levels_.back();
+					positions_.pop_back();
+					elapsed_times_.pop_back();
+					applied_levels_.pop_back();
+					continue;
+				}
+
+				i++;
+			}
+
+			API::auto_draw(*tabbar_ptr_, true);
+			if (is_changed)
+				API::refresh_window(*tabbar_ptr_);
+
+			return !positions_.empty();
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,519 @@
+﻿#include "line_diff.hpp"
+#include "file_system.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace text_overseer
+{
+	namespace line_diff
+	{
+		namespace
+		{
+			bool is_blank(char c) noexcept
+			{
+				return c == ' ' || c == '\t' || c == '\r';
+			}
+
+			const char* find_line_end(const char* first, const char* last) noexcept
+			{
+				const auto pos = static_cast<const char*>(std::memchr(first, '\n', last - first));
+				return pos != nullptr ? pos : last;
+			}
+
+			const char* skip_blanks(const char* pos, const char* last) noexcept
+			{
+				while (pos != last && is_blank(*pos))
+					pos++;
+				return pos;
+			}
+
+			bool has_token(const char* first, const char* last) noexcept
+			{
+				return skip_blanks(first, last) != last;
+			}
+
+			// FNV-1a, for the text hash of the answer cache
+			constexpr std::uint64_t k_hash_basis = 0xCBF29CE484222325;
+			constexpr std::uint64_t k_hash_prime = 0x100000001B3;
+
+			std::uint64_t hash_byte(std::uint64_t hash, unsigned char c) noexcept
+			{
+				return (hash ^ c) * k_hash_prime;
+			}
+
+			// calls func(token_first, token_last) for each token of a line until it returns false
+			template <class Func>
+			void for_each_token(const char* first, const char* last, Func&& func)
+			{
+				auto pos = skip_blanks(first, last);
+				while (pos != last)
+				{
+					const auto token_first = pos;
+					while (pos != last && !is_blank(*pos))
+						pos++;
+					if (!func(token_first, pos))
+						return;
+					pos = skip_blanks(pos, last);
+				}
+			}
+
+			// calls func(line_first, line_last) for each line starting in [first, last) until it returns false
+			// a chunk except the final one ends right after a newline; the final one also has the line after
+			// its last newline(it can be empty)
+			template <class Func>
+			void for_each_line(const char* first, const char* last, bool is_final, Func&& func)
+			{
+				auto pos = first;
+				while (pos != last)
+				{
+					const auto line_last = find_line_end(pos, last);
+					if (!func(pos, line_last) || line_last == last)
+						return;
+					pos = line_last + 1;
+				}
+				if (is_final)
+					func(last, last);
+			}
+
+			struct Chunk
+			{
+				const char*		first;
+				const char*		last;
+				std::uint64_t	line_count;
+				std::uint64_t	nonempty_count;
+				std::uint64_t	first_line;		// the line count of the former chunks
+				std::uint64_t	first_nonempty;	// the non-empty line count of the former chunks
+			};
+
+			// splits a text into about chunk_count chunks at line boundaries
+			void split_chunks(const char* first, const char* last, std::size_t chunk_count, std::vector<Chunk>& chunks)
+			{
+				const auto nominal_size = static_cast<std::size_t>(last - first) / chunk_count + 1;
+				chunks.clear();
+				auto pos = first;
+				while (pos != last)
+				{
+					auto chunk_last = last;
+					if (static_cast<std::size_t>(last - pos) > nominal_size)
+					{
+						chunk_last = find_line_end(pos + nominal_size, last);
+						if (chunk_last != last)
+							chunk_last++; // includes the newline
+					}
+					chunks.push_back(Chunk{ pos, chunk_last, 0, 0, 0, 0 });
+					pos = chunk_last;
+				}
+			}
+
+			void count_lines(Chunk& chunk, bool is_final) noexcept
+			{
+				for_each_line(chunk.first, chunk.last, is_final, [&chunk](const char* first, const char* last) {
+					chunk.line_count++;
+					if (has_token(first, last))
+						chunk.nonempty_count++;
+					return true;
+				});
+			}
+
+			void sum_chunks(std::vector<Chunk>& chunks) noexcept
+			{
+				std::uint64_t line = 0;
+				std::uint64_t nonempty = 0;
+				for (auto& chunk : chunks)
+				{
+					chunk.first_line = line;
+					chunk.first_nonempty = nonempty;
+					line += chunk.line_count;
+					nonempty += chunk.nonempty_count;
+				}
+			}
+
+			// compares the lines of a file chunk with the answer from its k-th non-empty line
+			// @returns the number of the different lines
+			std::uint64_t diff_chunk(
+				const Chunk&		chunk,
+				bool				is_final,
+				const AnswerIndex&	answer,
+				std::uint64_t*		words
+			) noexcept
+			{
+				auto k = chunk.first_nonempty;
+				std::uint64_t i = 0;
+				std::uint64_t different_count = 0;
+
+				for_each_line(chunk.first, chunk.last, is_final, [&](const char* f_first, const char* f_last) {
+					auto is_same = true;
+					if (has_token(f_first, f_last))
+					{
+						is_same = k < answer.nonempty_count() && answer.is_same_line(k, f_first, f_last);
+						k++;
+					}
+					if (is_same)
+						words[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+					else
+						different_count++;
+					i++;
+					return true;
+				});
+				return different_count;
+			}
+
+			// runs func(i) for every i in [0, count) on the diff workers and the calling thread
+			// the workers are made on the first large diff and kept; if some couldn't be made, it runs on fewer
+			// a single chunk, which is what most files make, runs inline without waking the workers
+			// func must not throw, since the batch ignores an exception
+			template <class Func>
+			void run_parallel(std::size_t count, const Func& func)
+			{
+				if (count == 1)
+				{
+					func(0);
+					return;
+				}
+
+				static file_system::BatchIO workers(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+				static std::mutex mutex; // a batch at a time, if diffs run on more than one thread
+
+				std::lock_guard<std::mutex> lock(mutex);
+				workers.run_all(count, func);
+			}
+		}
+
+		void AnswerIndex::build(const char* first, const char* last)
+		{
+			clear();
+			if (first == last)
+				return;
+
+			// count first, so that the arrays are allocated once
+			std::uint64_t nonempty_count = 0;
+			std::uint64_t token_count = 0;
+			for_each_line(first, last, true, [&](const char* line_first, const char* line_last) {
+				if (has_token(line_first, line_last))
+					nonempty_count++;
+				for_each_token(line_first, line_last, [&](const char*, const char*) {
+					token_count++;
+					return true;
+				});
+				return true;
+			});
+			text_ = first;
+			token_offsets_.reserve(static_cast<std::size_t>(token_count));
+			token_sizes_.reserve(static_cast<std::size_t>(token_count));
+			line_tokens_.reserve(static_cast<std::size_t>(nonempty_count + 1));
+			nonempty_lines_.reserve(static_cast<std::size_t>(nonempty_count));
+
+			for_each_line(first, last, true, [this, first](const char* line_first, const char* line_last) {
+				const auto line = line_count_++;
+				if (!has_token(line_first, line_last))
+					return true;
+
+				line_tokens_.push_back(token_offsets_.size());
+				for_each_token(line_first, line_last, [&](const char* token_first, const char* token_last) {
+					token_offsets_.push_back(static_cast<std::uint64_t>(token_first - first));
+					token_sizes_.push_back(static_cast<std::uint32_t>(token_last - token_first));
+					return true;
+				});
+				nonempty_lines_.push_back(line);
+				return true;
+			});
+			line_tokens_.push_back(token_offsets_.size());
+		}
+
+		void AnswerIndex::clear() noexcept
+		{
+			text_ = nullptr;
+			token_offsets_.clear();
+			token_sizes_.clear();
+			line_tokens_.clear();
+			nonempty_lines_.clear();
+			line_count_ = 0;
+		}
+
+		bool AnswerIndex::is_same_line(std::uint64_t k, const char* first, const char* last) const noexcept
+		{
+			const auto token_last = line_tokens_[k + 1];
+			auto token = line_tokens_[k];
+			auto is_same = true;
+
+			for_each_token(first, last, [&](const char* f_first, const char* f_last) {
+				const auto size = static_cast<std::size_t>(f_last - f_first);
+				if (token == token_last || size != token_sizes_[token]
+					|| std::memcmp(text_ + token_offsets_[token], f_first, size) != 0)
+				{
+					is_same = false;
+					return false;
+				}
+				token++;
+				return true;
+			});
+			return is_same && token == token_last;
+		}
+
+		std::shared_ptr<const SharedAnswer> AnswerCache::intern(std::string&& text)
+		{
+			const auto hash = _hash(text);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (auto answer = _find(hash, text))
+					return answer;
+			}
+
+			// index it out of the lock
+			auto answer = std::make_shared<SharedAnswer>();
+			answer->text = std::move(text);
+			answer->index.build(answer->text.data(), answer->text.data() + answer->text.size());
+
+			// another box unit may have interned the same text meanwhile(e.g. in the same batch of loads);
+			// then that one is shared, and this one is dropped
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (auto interned = _find(hash, answer->text))
+				return interned;
+			answers_.emplace(hash, answer);
+			return answer;
+		}
+
+		std::shared_ptr<const SharedAnswer> AnswerCache::_find(std::uint64_t hash, const std::string& text)
+		{
+			auto range = answers_.equal_range(hash);
+			for (auto it = range.first; it != range.second; )
+			{
+				auto answer = it->second.lock();
+				if (!answer)
+				{
+					it = answers_.erase(it); // no box unit holds it anymore
+					continue;
+				}
+				if (answer->text == text)
+					return answer;
+				++it;
+			}
+			return nullptr;
+		}
+
+		std::size_t AnswerCache::size() const noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return static_cast<std::size_t>(std::count_if(answers_.begin(), answers_.end(), [](const auto& entry) {
+				return !entry.second.expired();
+			}));
+		}
+
+		std::uint64_t AnswerCache::_hash(const std::string& text) noexcept
+		{
+			auto hash = k_hash_basis;
+			for (const auto c : text)
+				hash = hash_byte(hash, static_cast<unsigned char>(c));
+			return hash;
+		}
+
+		constexpr std::uint64_t LineDiffBits::k_block_bits;
+		constexpr std::uint64_t LineDiffBits::k_run_zeros;
+		constexpr std::uint64_t LineDiffBits::k_run_ones;
+
+		void LineDiffBits::clear() noexcept
+		{
+			runs_.clear();
+			raw_words_.clear();
+			tail_.fill(0);
+			size_ = 0;
+		}
+
+		void LineDiffBits::push_back(bool bit)
+		{
+			const auto pos_in_block = size_ % k_block_bits;
+			if (bit)
+				tail_[pos_in_block / 64] |= std::uint64_t{ 1 } << (pos_in_block % 64);
+			size_++;
+			if (size_ % k_block_bits == 0)
+				_seal_tail();
+		}
+
+		void LineDiffBits::append(const std::uint64_t* words, std::uint64_t bit_count)
+		{
+			std::uint64_t src_pos = 0;
+			while (src_pos < bit_count)
+			{
+				// copy as many bits as fit in the current word of the tail
+				const auto pos_in_block = size_ % k_block_bits;
+				const auto shift = pos_in_block % 64;
+				const auto src_shift = src_pos % 64;
+				const auto n = std::min({ 64 - shift, 64 - src_shift, bit_count - src_pos });
+				const auto mask = n == 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << n) - 1;
+				const auto bits = (words[src_pos / 64] >> src_shift) & mask;
+
+				tail_[pos_in_block / 64] |= bits << shift;
+				size_ += n;
+				src_pos += n;
+				if (size_ % k_block_bits == 0)
+					_seal_tail();
+			}
+		}
+
+		bool LineDiffBits::operator[](std::uint64_t pos) const noexcept
+		{
+			const auto block = pos / k_block_bits;
+			const auto pos_in_block = pos % k_block_bits;
+			const auto sealed_blocks = size_ / k_block_bits;
+
+			if (block == sealed_blocks)
+				return (tail_[pos_in_block / 64] >> (pos_in_block % 64)) & 1;
+
+			// the last run whose first block isn't after the block
+			const auto it = std::upper_bound(runs_.begin(), runs_.end(), block, [](std::uint64_t b, const Run& run) {
+				return b < run.first_block;
+			}) - 1;
+			if (it->raw_first == k_run_zeros)
+				return false;
+			if (it->raw_first == k_run_ones)
+				return true;
+			const auto word_index = (it->raw_first + block - it->first_block) * k_block_words + pos_in_block / 64;
+			return (raw_words_[word_index] >> (pos_in_block % 64)) & 1;
+		}
+
+		std::size_t AnswerIndex::memory_size() const noexcept
+		{
+			return token_sizes_.capacity() * sizeof(std::uint32_t) + (token_offsets_.capacity()
+				+ line_tokens_.capacity() + nonempty_lines_.capacity()) * sizeof(std::uint64_t);
+		}
+
+		std::size_t LineDiffBits::memory_size() const noexcept
+		{
+			return runs_.capacity() * sizeof(Run) + raw_words_.capacity() * sizeof(std::uint64_t);
+		}
+
+		void LineDiffBits::to_runs(std::vector<std::uint64_t>& run_lengths) const
+		{
+			run_lengths.clear();
+			auto last_bit = false;
+
+			const auto add_run = [&](bool bit, std::uint64_t count) {
+				if (count == 0)
+					return;
+				if (!run_lengths.empty() && bit == last_bit)
+				{
+					run_lengths.back() += count;
+					return;
+				}
+				if (run_lengths.empty() && bit)
+					run_lengths.push_back(0);
+				run_lengths.push_back(count);
+				last_bit = bit;
+			};
+
+			const auto add_words = [&](const std::uint64_t* words, std::uint64_t bit_count) {
+				for (; bit_count >= 64; bit_count -= 64, words++)
+				{
+					if (*words == 0 || *words == ~std::uint64_t{ 0 })
+					{
+						add_run(*words != 0, 64);
+						continue;
+					}
+					for (unsigned int i = 0; i < 64; i++)
+						add_run((*words >> i) & 1, 1);
+				}
+				for (unsigned int i = 0; i < bit_count; i++)
+					add_run((*words >> i) & 1, 1);
+			};
+
+			const auto sealed_blocks = size_ / k_block_bits;
+			for (std::size_t i = 0; i < runs_.size(); i++)
+			{
+				const auto& run = runs_[i];
+				const auto last_block = i + 1 < runs_.size() ? runs_[i + 1].first_block : sealed_blocks;
+				const auto bit_count = (last_block - run.first_block) * k_block_bits;
+				if (run.raw_first == k_run_zeros || run.raw_first == k_run_ones)
+					add_run(run.raw_first == k_run_ones, bit_count);
+				else
+					add_words(&raw_words_[static_cast<std::size_t>(run.raw_first * k_block_words)], bit_count);
+			}
+			add_words(tail_.data(), size_ % k_block_bits);
+		}
+
+		void LineDiffBits::_seal_tail()
+		{
+			const auto block = size_ / k_block_bits - 1;
+			const auto is_zeros = std::all_of(tail_.begin(), tail_.end(), [](std::uint64_t w) { return w == 0; });
+			const auto is_ones = std::all_of(tail_.begin(), tail_.end(), [](std::uint64_t w) { return w == ~std::uint64_t{ 0 }; });
+
+			if (is_zeros || is_ones)
+			{
+				const auto kind = is_ones ? k_run_ones : k_run_zeros;
+				if (runs_.empty() || runs_.back().raw_first != kind)
+					runs_.push_back(Run{ block, kind });
+			}
+			else
+			{
+				// consecutive raw blocks share a run since they're contiguous in raw_words_
+				const auto raw_block = raw_words_.size() / k_block_words;
+				const auto does_extend = !runs_.empty()
+					&& runs_.back().raw_first != k_run_zeros && runs_.back().raw_first != k_run_ones;
+				if (!does_extend)
+					runs_.push_back(Run{ block, raw_block });
+				raw_words_.insert(raw_words_.end(), tail_.begin(), tail_.end());
+			}
+			tail_.fill(0);
+		}
+
+		LineDiffResult diff_lines(
+			const char*			file_first,
+			const char*			file_last,
+			const AnswerIndex&	answer,
+			LineDiffBits&		results,
+			std::size_t			thread_count
+		)
+		{
+			LineDiffResult result;
+			results.clear();
+
+			if (file_first == file_last || answer.empty())
+				return result; // diff_status::error
+
+			const auto by_size = static_cast<std::size_t>(file_last - file_first) / k_min_parallel_chunk_size;
+			std::vector<Chunk> chunks;
+			split_chunks(file_first, file_last, std::max<std::size_t>(1, std::min(thread_count, by_size)), chunks);
+			const auto chunk_count = chunks.size();
+
+			// 1st pass: count the lines of every chunk, so each chunk knows its first non-empty line
+			run_parallel(chunk_count, [&](std::size_t i) {
+				count_lines(chunks[i], i + 1 == chunk_count);
+			});
+			sum_chunks(chunks);
+
+			// 2nd pass: compare each chunk from its first non-empty line on the answer
+			std::vector<std::vector<std::uint64_t>> chunk_words(chunk_count);
+			std::vector<std::uint64_t> different_counts(chunk_count, 0);
+			for (std::size_t i = 0; i < chunk_count; i++)
+				chunk_words[i].assign(static_cast<std::size_t>((chunks[i].line_count + 63) / 64), 0);
+			run_parallel(chunk_count, [&](std::size_t i) {
+				different_counts[i] = diff_chunk(chunks[i], i + 1 == chunk_count, answer, chunk_words[i].data());
+			});
+
+			// stitch the results in order
+			for (std::size_t i = 0; i < chunk_count; i++)
+			{
+				results.append(chunk_words[i].data(), chunks[i].line_count);
+				result.different_line_count += different_counts[i];
+			}
+
+			const auto& back = chunks.back();
+			const auto nonempty_count = back.first_nonempty + back.nonempty_count;
+
+			result.file_line_count = back.first_line + back.line_count;
+			result.answer_line_count = answer.line_count();
+			if (nonempty_count < answer.nonempty_count())
+			{
+				result.status = diff_status::file_shorter;
+				result.first_unmatched_answer_line = answer.nonempty_line(nonempty_count);
+			}
+			else
+			{
+				result.status = diff_status::done;
+				result.first_unmatched_answer_line = answer.line_count();
+			}
+			return result;
+		}
+	}
+}
\ No newline at end of file
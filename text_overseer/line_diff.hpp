@@ -0,0 +1,143 @@
+﻿#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace text_overseer
+{
+	namespace line_diff
+	{
+		enum class diff_status
+		{
+			done,			// every line of the file was compared
+			error,			// there's nothing to compare(the file or the answer is empty)
+			file_shorter	// the file has fewer lines than the answer
+		};
+
+		constexpr std::size_t k_min_parallel_chunk_size = 0x100000; // a smaller text isn't worth a thread
+
+		struct LineDiffResult
+		{
+			diff_status		status{ diff_status::error };
+			std::uint64_t	file_line_count{ 0 };
+			std::uint64_t	answer_line_count{ 0 };
+			std::uint64_t	first_unmatched_answer_line{ 0 }; // the answer lines from it have no pair in the file
+			std::uint64_t	different_line_count{ 0 }; // the non-empty lines of the file different from the answer
+		};
+
+		// a compact bitset of the per-line results (true: the line is the same as the answer)
+		// the bits are sealed in blocks of 512; a block of all the same bits isn't stored but merged into a run,
+		// so long matching stretches cost nearly nothing, and the other blocks cost a bit per line
+		// it's append-only, like the line diff that builds it
+		class LineDiffBits
+		{
+		public:
+			static constexpr std::uint64_t k_block_bits = 512;
+
+			void clear() noexcept;
+			void push_back(bool bit);
+			void append(const std::uint64_t* words, std::uint64_t bit_count); // bits in the LSB-first order
+			bool operator[](std::uint64_t pos) const noexcept; // pos must be less than size()
+			std::uint64_t size() const noexcept { return size_; }
+			bool empty() const noexcept { return size_ == 0; }
+			std::size_t memory_size() const noexcept; // the heap bytes in use
+
+			// run-length encodes the bits; the runs alternate between false and true, beginning with false
+			// (the first run is 0 long if the first bit is true)
+			void to_runs(std::vector<std::uint64_t>& run_lengths) const;
+
+		private:
+			static constexpr std::size_t k_block_words = k_block_bits / 64;
+			static constexpr std::uint64_t k_run_zeros = ~std::uint64_t{ 0 };
+			static constexpr std::uint64_t k_run_ones = ~std::uint64_t{ 0 } - 1;
+
+			// a run of sealed blocks; it lasts until the first block of the next run
+			struct Run
+			{
+				std::uint64_t first_block;
+				std::uint64_t raw_first; // k_run_zeros, k_run_ones, or the index of its first block in raw_words_
+			};
+
+			void _seal_tail();
+
+			std::vector<Run>							runs_;
+			std::vector<std::uint64_t>					raw_words_;
+			std::array<std::uint64_t, k_block_words>	tail_{}; // the block being filled
+			std::uint64_t								size_{ 0 };
+		};
+
+		// the answer tokenized once into flat arrays; it's reused over the diffs until the answer is edited
+		// only the non-empty lines are indexed, so the k-th non-empty line is found directly
+		// the tokens are kept as positions in the answer text, not as copies
+		class AnswerIndex
+		{
+		public:
+			// the text must outlive the index and stay unchanged, e.g. SharedAnswer::text
+			void build(const char* first, const char* last);
+			void clear() noexcept;
+			bool empty() const noexcept { return line_count_ == 0; } // the answer text was empty
+			std::uint64_t line_count() const noexcept { return line_count_; }
+			std::uint64_t nonempty_count() const noexcept { return nonempty_lines_.size(); }
+			std::uint64_t nonempty_line(std::uint64_t k) const noexcept { return nonempty_lines_[k]; } // the line number
+			std::size_t memory_size() const noexcept; // the heap bytes in use
+
+			// whether the k-th non-empty line has the same tokens as [first, last)
+			// each token is compared by its size first, and then by its bytes in the answer text
+			// the answer is never tokenized again
+			bool is_same_line(std::uint64_t k, const char* first, const char* last) const noexcept;
+
+		private:
+			const char*					text_{ nullptr };	// the answer text built from
+			std::vector<std::uint64_t>	token_offsets_;		// token i starts at text_ + token_offsets_[i]
+			std::vector<std::uint32_t>	token_sizes_;
+			std::vector<std::uint64_t>	line_tokens_;		// non-empty line k has tokens [line_tokens_[k], [k + 1])
+			std::vector<std::uint64_t>	nonempty_lines_;	// the line number of each non-empty line
+			std::uint64_t				line_count_{ 0 };
+		};
+
+		// an answer text with its index, shared by every tab page whose answer file has the same content
+		// the index points into the text, so it's never copied nor changed once built
+		struct SharedAnswer
+		{
+			std::string	text; // UTF-8
+			AnswerIndex	index;
+		};
+
+		// a content-addressed cache of the answers read from files; the same content is tokenized only once
+		// it only keeps weak references, so an answer is freed when no box unit holds it anymore
+		// it's thread-safe, so the answer files can be loaded in a batch
+		class AnswerCache
+		{
+		public:
+			// returns the shared answer of the same text, or indexes the text and shares it
+			std::shared_ptr<const SharedAnswer> intern(std::string&& text);
+			std::size_t size() const noexcept; // the number of the live answers
+
+		private:
+			static std::uint64_t _hash(const std::string& text) noexcept;
+			std::shared_ptr<const SharedAnswer> _find(std::uint64_t hash, const std::string& text); // in the lock
+
+			mutable std::mutex mutex_;
+			std::unordered_multimap<std::uint64_t, std::weak_ptr<const SharedAnswer>> answers_; // by the text hash
+		};
+
+		// compares the lines of a file with the lines of an answer, ignoring empty lines and blanks(' ', '\t', '\r')
+		// the k-th non-empty line of the file is compared with the k-th non-empty line of the answer
+		// a large text is split at line boundaries into chunks, which are compared on a pool of worker threads
+		// @param results: the result of each line of the file; an empty line counts as the same
+		// @param thread_count: the maximum number of threads
+		LineDiffResult diff_lines(
+			const char*			file_first,
+			const char*			file_last,
+			const AnswerIndex&	answer,
+			LineDiffBits&		results,
+			std::size_t			thread_count = std::thread::hardware_concurrency()
+		);
+	}
+}
\ No newline at end of file
@@ -1,9 +1,176 @@
 ﻿#include "gui.hpp"
-//#include "error_handler.hpp"
+#include "error_handler.hpp"
+#include "fixture.hpp"
 
-int main()
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace
 {
-	text_overseer::gui::MainWindow window;
+	using namespace text_overseer;
+
+	// the options of the fixture generator; it runs without the window, and logs what it did
+	//   --make-fixtures <folders>: writes the folders of input/output/answer files
+	//   --churn <rewrites per sec>: keeps rewriting the output files for --seconds <seconds>
+	//   --check-stamps: with --churn, fails if a rewrite doesn't change the file stamp
+	//   --dir <path>, --lines <count>, --tokens <per line>, --mismatch <rate>, --seed <num>, --threads <count>,
+	//   --encoding <ansi|utf8|utf8-bom|utf16le|utf16be>
+	struct FixtureCommand
+	{
+		fixture::FixtureOptions options;
+		bool do_make_fixtures{ false };
+		double churn_rate{ 0.0 };
+		double churn_seconds{ 60.0 };
+		bool do_check_stamps{ false };
+		const char* bad_encoding{ nullptr }; // the value of --encoding that isn't one of the names above
+	};
+
+	bool parse_encoding(const char* name, file_io::FileIO::encoding& locale) noexcept
+	{
+		using e = file_io::FileIO::encoding;
+		if (std::strcmp(name, "ansi") == 0)
+			locale = e::system;
+		else if (std::strcmp(name, "utf8") == 0)
+			locale = e::utf8_no_bom;
+		else if (std::strcmp(name, "utf8-bom") == 0)
+			locale = e::utf8;
+		else if (std::strcmp(name, "utf16le") == 0)
+			locale = e::utf16_le;
+		else if (std::strcmp(name, "utf16be") == 0)
+			locale = e::utf16_be;
+		else
+			return false;
+		return true;
+	}
+
+	// @returns false if there's no fixture option
+	bool parse_fixture_command(int argc, char* argv[], FixtureCommand& command)
+	{
+		auto& options = command.options;
+		auto has_command = false;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const char* name = argv[i];
+			if (std::strcmp(name, "--check-stamps") == 0)
+			{
+				command.do_check_stamps = true;
+				continue;
+			}
+			if (i + 1 == argc)
+				break;
+			const char* value = argv[i + 1];
+
+			if (std::strcmp(name, "--make-fixtures") == 0)
+			{
+				options.folder_count = std::strtoul(value, nullptr, 10);
+				command.do_make_fixtures = has_command = true;
+			}
+			else if (std::strcmp(name, "--churn") == 0)
+			{
+				command.churn_rate = std::strtod(value, nullptr);
+				has_command = true;
+			}
+			else if (std::strcmp(name, "--seconds") == 0)
+				command.churn_seconds = std::strtod(value, nullptr);
+			else if (std::strcmp(name, "--dir") == 0)
+				options.root_dir = file_system::filesys::path(value).wstring();
+			else if (std::strcmp(name, "--lines") == 0)
+				options.line_count = std::strtoul(value, nullptr, 10);
+			else if (std::strcmp(name, "--tokens") == 0)
+				options.tokens_per_line = std::strtoul(value, nullptr, 10);
+			else if (std::strcmp(name, "--mismatch") == 0)
+				options.mismatch_rate = std::strtod(value, nullptr);
+			else if (std::strcmp(name, "--seed") == 0)
+				options.seed = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+			else if (std::strcmp(name, "--threads") == 0)
+				options.thread_count = std::strtoul(value, nullptr, 10);
+			else if (std::strcmp(name, "--encoding") == 0)
+			{
+				if (!parse_encoding(value, options.locale))
+					command.bad_encoding = value;
+			}
+			else
+				continue;
+			i++; // the value is taken
+		}
+
+		return has_command;
+	}
+
+	int run_fixture_command(const FixtureCommand& command)
+	{
+		using error_handler::ErrorHdr;
+		ErrorHdr::instance().start();
+
+		if (command.bad_encoding != nullptr)
+		{
+			ErrorHdr::instance().report(
+				ErrorHdr::priority::critical, 0, "Fixtures - unknown encoding", command.bad_encoding
+			);
+			return 1;
+		}
+
+		if (command.do_make_fixtures)
+		{
+			const auto start_time = std::chrono::steady_clock::now();
+			const auto failed_count = fixture::generate_fixtures(command.options);
+			const auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start_time
+			).count();
+
+			std::ostringstream oss;
+			oss << "Fixtures - " << command.options.folder_count << " folders in " << msecs << " ms, "
+				<< failed_count << " failed";
+			ErrorHdr::instance().report(ErrorHdr::priority::info, 0, oss.str());
+			if (failed_count != 0)
+				return 1;
+		}
+
+		if (command.churn_rate > 0.0)
+		{
+			const auto stats = fixture::run_churn(
+				command.options,
+				command.churn_rate,
+				std::chrono::milliseconds(static_cast<long long>(command.churn_seconds * 1000)),
+				nullptr,
+				command.do_check_stamps
+			);
+
+			std::ostringstream oss;
+			oss << "Churn - " << stats.rewrite_count << " rewrites in " << stats.elapsed.count() << " ms";
+			if (command.do_check_stamps)
+				oss << ", " << stats.detected_count << " changed the file stamp";
+			const auto is_missed = command.do_check_stamps && stats.detected_count < stats.rewrite_count;
+			ErrorHdr::instance().report(
+				is_missed ? ErrorHdr::priority::warning : ErrorHdr::priority::info, 0, oss.str()
+			);
+			if (is_missed)
+				return 1;
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	text_overseer::gui::StartupTrace startup_trace; // the start time is now
+
+	// the fixture generator doesn't open the window
+	FixtureCommand fixture_command;
+	if (parse_fixture_command(argc, argv, fixture_command))
+		return run_fixture_command(fixture_command);
+
+	// --trace-startup: log the time to the first frame and to all the tabs
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--trace-startup") == 0)
+			startup_trace.is_enabled = true;
+	}
+
+	text_overseer::gui::MainWindow window{ startup_trace };
 	window.show();
 	nana::exec();
 	return 0;
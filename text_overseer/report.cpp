@@ -0,0 +1,176 @@
+﻿#include "report.hpp"
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace text_overseer
+{
+	namespace report
+	{
+		namespace
+		{
+			// FNV-1a, the same as the answer cache uses
+			constexpr std::uint64_t k_hash_basis = 0xCBF29CE484222325;
+			constexpr std::uint64_t k_hash_prime = 0x100000001B3;
+
+			template <class T>
+			void put(std::string& bytes, std::size_t offset, const T& value) noexcept
+			{
+				std::memcpy(&bytes[offset], &value, sizeof(T));
+			}
+		}
+
+		FileFingerprint fingerprint_file(const std::wstring& path_str, std::string& buf)
+		{
+			FileFingerprint fingerprint{ 0, 0 };
+
+			file_io::FileIO file(path_str);
+			if (!file.open(std::ios::in | std::ios::binary))
+				return fingerprint;
+
+			buf.resize(static_cast<std::size_t>(file.stream_size()));
+			if (!buf.empty())
+				file.read_bytes(&buf[0], buf.size());
+
+			fingerprint.size = buf.size();
+			fingerprint.hash = k_hash_basis;
+			for (const auto c : buf)
+				fingerprint.hash = (fingerprint.hash ^ static_cast<unsigned char>(c)) * k_hash_prime;
+			return fingerprint;
+		}
+
+		bool write_report(const std::wstring& path_str, const std::vector<CaseSnapshot>& cases)
+		{
+			std::uint64_t run_count = 0;
+			std::uint64_t string_pool_size = 0;
+			for (const auto& snapshot : cases)
+			{
+				run_count += snapshot.run_lengths.size();
+				string_pool_size += snapshot.name.size();
+			}
+			string_pool_size = (string_pool_size + 7) / 8 * 8;
+
+			const auto records_offset = sizeof(ReportHeader);
+			const auto runs_offset = records_offset + sizeof(CaseRecord) * cases.size();
+			const auto string_pool_offset = runs_offset + sizeof(std::uint64_t) * static_cast<std::size_t>(run_count);
+			std::string bytes(string_pool_offset + static_cast<std::size_t>(string_pool_size), '\0');
+
+			ReportHeader header{};
+			std::memcpy(header.magic, k_report_magic, sizeof(header.magic));
+			header.version = k_report_version;
+			header.byte_order = k_report_byte_order;
+			header.case_count = static_cast<std::uint32_t>(cases.size());
+			header.run_count = run_count;
+			header.string_pool_size = string_pool_size;
+			put(bytes, 0, header);
+
+			std::uint64_t first_run = 0;
+			std::uint64_t name_offset = 0;
+			for (std::size_t i = 0; i < cases.size(); i++)
+			{
+				const auto& snapshot = cases[i];
+
+				CaseRecord record{};
+				record.name_offset = name_offset;
+				record.name_size = static_cast<std::uint32_t>(snapshot.name.size());
+				record.input_encoding = snapshot.input_encoding;
+				record.verdict = snapshot.verdict;
+				record.input = snapshot.input;
+				record.output = snapshot.output;
+				record.answer = snapshot.answer;
+				record.line_count = snapshot.line_count;
+				record.different_line_count = snapshot.different_line_count;
+				record.first_run = first_run;
+				record.run_count = snapshot.run_lengths.size();
+				put(bytes, records_offset + sizeof(CaseRecord) * i, record);
+
+				if (!snapshot.run_lengths.empty())
+				{
+					std::memcpy(
+						&bytes[runs_offset + sizeof(std::uint64_t) * static_cast<std::size_t>(first_run)],
+						snapshot.run_lengths.data(),
+						sizeof(std::uint64_t) * snapshot.run_lengths.size()
+					);
+				}
+				std::copy(
+					snapshot.name.begin(), snapshot.name.end(),
+					bytes.begin() + string_pool_offset + static_cast<std::size_t>(name_offset)
+				);
+
+				first_run += record.run_count;
+				name_offset += record.name_size;
+			}
+
+			// UTF-8 without BOM has no BOM to be written before the report
+			file_io::FileIO file(path_str, file_io::FileIO::encoding::utf8_no_bom);
+			return file.write_all_atomic(bytes, bytes.size(), false);
+		}
+
+		bool ReportReader::open(const std::wstring& path_str)
+		{
+			header_ = nullptr;
+
+			file_io::FileIO file(path_str);
+			if (!file.open(std::ios::in | std::ios::binary))
+				return false;
+
+			const auto byte_size = static_cast<std::size_t>(file.stream_size());
+			if (byte_size % sizeof(std::uint64_t) != 0)
+				return false;
+
+			buffer_.resize(byte_size / sizeof(std::uint64_t));
+			if (byte_size != 0)
+				file.read_bytes(buffer_.data(), byte_size);
+			return attach(buffer_.data(), byte_size);
+		}
+
+		bool ReportReader::attach(const void* data, std::size_t byte_size) noexcept
+		{
+			header_ = nullptr;
+
+			const auto bytes = static_cast<const char*>(data);
+			if (byte_size < sizeof(ReportHeader) || reinterpret_cast<std::uintptr_t>(data) % 8 != 0)
+				return false;
+
+			const auto header = reinterpret_cast<const ReportHeader*>(bytes);
+			if (std::memcmp(header->magic, k_report_magic, sizeof(header->magic)) != 0
+				|| header->version != k_report_version || header->byte_order != k_report_byte_order)
+				return false;
+
+			// the sections must fit in the data
+			const std::uint64_t records_size = sizeof(CaseRecord) * std::uint64_t{ header->case_count };
+			const auto max_runs = (byte_size - sizeof(ReportHeader)) / sizeof(std::uint64_t);
+			if (header->run_count > max_runs || header->string_pool_size > byte_size
+				|| sizeof(ReportHeader) + records_size + header->run_count * sizeof(std::uint64_t)
+				+ header->string_pool_size != byte_size)
+				return false;
+
+			const auto records = reinterpret_cast<const CaseRecord*>(bytes + sizeof(ReportHeader));
+			const auto runs = reinterpret_cast<const std::uint64_t*>(bytes + sizeof(ReportHeader) + records_size);
+			const auto string_pool = reinterpret_cast<const char*>(runs + header->run_count);
+
+			for (std::uint32_t i = 0; i < header->case_count; i++)
+			{
+				const auto& record = records[i];
+				if (record.first_run > header->run_count || record.run_count > header->run_count - record.first_run
+					|| record.name_offset > header->string_pool_size
+					|| record.name_size > header->string_pool_size - record.name_offset)
+					return false;
+			}
+
+			header_ = header;
+			records_ = records;
+			runs_ = runs;
+			string_pool_ = string_pool;
+			return true;
+		}
+
+		std::string ReportReader::name(std::size_t pos) const
+		{
+			const auto& record = records_[pos];
+			return std::string(string_pool_ + record.name_offset, record.name_size);
+		}
+	}
+}
\ No newline at end of file
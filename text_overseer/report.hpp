@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace text_overseer
+{
+	namespace report
+	{
+		// the layout of a report file; every section is 8-byte aligned, so a report can be memory-mapped and
+		// read in place; the integers are in the byte order of the machine which wrote it, which is marked by
+		// ReportHeader::byte_order, and a reader of the other byte order rejects the report
+		//   ReportHeader | CaseRecord * case_count | run lengths(uint64) * run_count | string pool
+		constexpr char k_report_magic[8] = { 'T', 'O', 'V', 'R', 'P', 'R', 'T', '\0' };
+		constexpr std::uint32_t k_report_version = 2;
+		constexpr std::uint32_t k_report_byte_order = 0x01020304; // reads 0x04030201 in the other byte order
+
+		struct ReportHeader
+		{
+			char			magic[8];
+			std::uint32_t	version;
+			std::uint32_t	byte_order; // k_report_byte_order
+			std::uint32_t	case_count;
+			std::uint32_t	reserved;
+			std::uint64_t	run_count;
+			std::uint64_t	string_pool_size;
+		};
+
+		// the size and the content hash(FNV-1a) of a file; both are 0 if the file doesn't exist
+		struct FileFingerprint
+		{
+			std::uint64_t	size;
+			std::uint64_t	hash;
+		};
+
+		struct CaseRecord
+		{
+			std::uint64_t	name_offset; // in the string pool; the name is UTF-8
+			std::uint32_t	name_size;
+			std::uint8_t	input_encoding; // file_io::FileIO::encoding
+			std::uint8_t	verdict; // gui::case_verdict
+			std::uint8_t	reserved[2];
+			FileFingerprint	input;
+			FileFingerprint	output;
+			FileFingerprint	answer;
+			std::uint64_t	line_count; // the lines of the output file compared
+			std::uint64_t	different_line_count;
+			std::uint64_t	first_run; // the line results, as line_diff::LineDiffBits::to_runs() makes
+			std::uint64_t	run_count; // 0 if the case wasn't compared
+		};
+
+		static_assert(sizeof(ReportHeader) % 8 == 0, "the sections must be 8-byte aligned");
+		static_assert(sizeof(CaseRecord) % 8 == 0, "the sections must be 8-byte aligned");
+
+		// what a case looked like, to be written into a report
+		struct CaseSnapshot
+		{
+			std::string					name;
+			std::uint8_t				input_encoding{ 0 };
+			std::uint8_t				verdict{ 0 };
+			FileFingerprint				input{};
+			FileFingerprint				output{};
+			FileFingerprint				answer{};
+			std::uint64_t				line_count{ 0 };
+			std::uint64_t				different_line_count{ 0 };
+			std::vector<std::uint64_t>	run_lengths;
+		};
+
+		// reads the whole file and hashes it
+		// @throws std::runtime_error if the file couldn't be read entirely
+		FileFingerprint fingerprint_file(const std::wstring& path_str, std::string& buf);
+
+		// lays the cases out into a report and writes it atomically(see FileIO::write_all_atomic())
+		// @throws std::runtime_error if writing failed
+		bool write_report(const std::wstring& path_str, const std::vector<CaseSnapshot>& cases);
+
+		// reads a report without parsing it; the records and the runs are used in place
+		class ReportReader
+		{
+		public:
+			// reads the report file with one read
+			// @returns false if it's not a valid report
+			// @throws std::runtime_error if the file couldn't be read entirely
+			bool open(const std::wstring& path_str);
+
+			// uses a report in memory, e.g. a mapped file; it must be 8-byte aligned and outlive the reader
+			// @returns false if it's not a valid report
+			bool attach(const void* data, std::size_t byte_size) noexcept;
+
+			std::size_t size() const noexcept { return header_ != nullptr ? header_->case_count : 0; }
+			const CaseRecord& operator[](std::size_t pos) const noexcept { return records_[pos]; }
+			std::string name(std::size_t pos) const;
+
+			// the run lengths of the line results of a case
+			const std::uint64_t* runs_begin(std::size_t pos) const noexcept { return runs_ + records_[pos].first_run; }
+			const std::uint64_t* runs_end(std::size_t pos) const noexcept { return runs_begin(pos) + records_[pos].run_count; }
+
+		private:
+			std::vector<std::uint64_t>	buffer_; // the report read by open()
+			const ReportHeader*			header_{ nullptr };
+			const CaseRecord*			records_{ nullptr };
+			const std::uint64_t*		runs_{ nullptr };
+			const char*					string_pool_{ nullptr };
+		};
+	}
+}
\ No newline at end of file